@@ -15,6 +15,8 @@ Key Features:
 - Handling of special moves such as castling and en passant
 - Pawn promotion via a simple dialog
 - Communication with an external chess engine (main.exe) for move generation
+- Pondering: the engine keeps running in server mode and thinks on the player's time
+- Check-aware move highlighting and game status from the frostweb Python module, when it is built
 
 Author: Anshuman Routray
 
@@ -23,7 +25,9 @@ Date: October 11th, 2024
 Usage:
 
 To run this script, ensure that the necessary sound files are available in a 'Sounds' directory. Additionally, the executable 'main.exe' 
-must be placed in an 'Executable' directory relative to this script. The chessboard can be interacted with by clicking on the pieces 
+must be placed in an 'Executable' directory relative to this script, built from the current sources, as the GUI talks to its
+server mode (mode 3). The frostweb module
+(FrostWeb/frostwebModule.cpp) can be placed there too, otherwise the GUI falls back to its own move generator. The chessboard can be interacted with by clicking on the pieces 
 to move them, with the engine generating responses for the opponent's moves.
 
 """
@@ -32,6 +36,13 @@ import tkinter as tk
 import subprocess
 import pygame
 import time
+import sys
+
+sys.path.insert(0, "Executable")
+try:
+    import frostweb  # The engine in process, see FrostWeb/frostwebModule.cpp
+except ImportError:
+    frostweb = None
 
 # Mapping for chess pieces
 chess_pieces = {
@@ -47,6 +58,56 @@ rageSound = pygame.mixer.Sound("Sounds/RageQuitter.wav")
 first_click = None
 board = []  # This will be the board state
 legal_moves = []  # To store all legal moves for the selected piece
+engine = None  # The engine server, kept running between moves so it can ponder
+predicted_board = None  # The board the engine expects after the player's move
+pondering = False
+
+def start_engine():
+    global engine
+    engine = subprocess.Popen(
+        ["Executable/main.exe"],
+            stdin=subprocess.PIPE, stdout=subprocess.PIPE, stderr=subprocess.DEVNULL, text=True, bufsize=1)
+    engine.stdin.write("3\n")
+
+def engine_command(command):
+    engine.stdin.write("gui " + command + "\n")
+    engine.stdin.flush()
+
+def engine_reply(kind):
+    # Wait for the reply of the given kind, skipping errors, and drop the session name
+    while True:
+        line = engine.stdout.readline()
+        if line == "":
+            # End of output: the engine exited, or it is an older main.exe without server mode 3
+            raise RuntimeError("The engine stopped (exit code " + str(engine.wait()) + ") before its "
+                + kind + " reply, Executable/main.exe has to be built from the current FrostWeb sources")
+        words = line.split()
+        if len(words) >= 2 and words[1] == kind:
+            return words[2:]
+
+def engine_board():
+    engine_command("board")
+    values = list(map(int, engine_reply("board")))
+    return [values[i * 8:i * 8 + 8] for i in range(8)] + [values[64:]]
+
+def game_status(board):
+    # 100 if the game goes on, -1 if the player to move is checkmated, 0 for a draw
+    if frostweb is not None:
+        return frostweb.Position(board).status()
+    input_str = "2\n"
+    for row in board:
+        input_str += " ".join(map(str, row)) + "\n"
+
+    # Call the main.exe executable
+    process = subprocess.Popen(
+        ["Executable/main.exe"], 
+            stdin=subprocess.PIPE, stdout=subprocess.PIPE, stderr=subprocess.PIPE, text=True)
+    # Send the board as input to the engine
+    stdout_data, stderr_data = process.communicate(input=input_str.strip())
+    return int(stdout_data)
+
+def board_string(board):
+    return " ".join(" ".join(map(str, row)) for row in board)
 
 # Function to highlight legal squares
 def highlight_legal_moves(canvas, legal_moves, square_size=80):
@@ -80,6 +141,10 @@ def is_legal_move(row, col):
 
 # Function to get all legal moves for a piece at (row, col)
 def get_legal_moves(row, col, board):
+    # The engine knows about checks and pins, the moves below do not
+    if frostweb is not None:
+        return frostweb.Position(board).legal_moves(row, col)
+
     piece = board[row][col]
     moves = []
 
@@ -208,6 +273,11 @@ def on_square_click(event, root, square_size = 80):
             captureSound.play()
         else:
             moveSound.play()
+        # Update the half move clock (reset by captures and pawn moves)
+        if abs(piece) == 1 or board[end_row][end_col] != 0:
+            board[8][6] = 0
+        else:
+            board[8][6] += 1
         board[end_row][end_col] = piece
         # Handle castling logic
         if abs(piece) == 6 and abs(start_col - end_col) == 2:  
@@ -263,18 +333,8 @@ def on_square_click(event, root, square_size = 80):
         
         root.update()
 
-        input_str = "2\n"
-        for row in board:
-            input_str += " ".join(map(str, row)) + "\n"
-
-        # Call the main.exe executable
-        process = subprocess.Popen(
-            ["Executable/main.exe"], 
-                stdin=subprocess.PIPE, stdout=subprocess.PIPE, stderr=subprocess.PIPE, text=True)
-        # Send the board as input to the engine
-        stdout_data, stderr_data = process.communicate(input=input_str.strip())
         message = None
-        stdout_data = int(stdout_data)
+        stdout_data = game_status(board)
         if stdout_data == -1:
             loserSound.play()
             message = "I WIN :)"
@@ -331,51 +391,54 @@ def drawBoard(canvas, root, board, square_size = 80):
                 canvas.tag_bind(piece_text, "<Button-1>", lambda event, sq_size=square_size: on_square_click(event, root, sq_size))
 
 def make_engine_move(root):
-    global board
-    # Convert the current board to the input format for the engine
-    input_str = "1\n"
-    for row in board:
-        input_str += " ".join(map(str, row)) + "\n"
-
-    # Call the main.exe executable
-    process = subprocess.Popen(
-        ["Executable/main.exe"], 
-            stdin=subprocess.PIPE, stdout=subprocess.PIPE, stderr=subprocess.PIPE, text=True
-    )
-    
-    # Send the board as input to the engine
-    stdout_data, stderr_data = process.communicate(input=input_str.strip())
+    global board, pondering, predicted_board
+    # If the player made the expected move the engine has been searching this position already
+    if pondering and board[:8] == predicted_board[:8] and board[8][2] == predicted_board[8][2]:
+        engine_command("ponderhit")
+    else:
+        if pondering:
+            engine_command("stop")
+            engine_reply("bestmove")
+        engine_command("position board " + board_string(board))
+        engine_command("go depth 4 movetime 60000")
+    pondering = False
 
-    # Parse the output back into a 2D list
-    lines = stdout_data.strip().splitlines()
-    new_board = [list(map(int, line.split())) for line in lines]
+    # The reply is: bestmove <move> ponder <move> score <pawns> ...
+    reply = engine_reply("bestmove")
 
-    # Update the board and redraw it
-    if len(new_board) == 1 and len(new_board[0]) == 1:
-        outcome = new_board[0][0]
+    if reply[0] == "none":
+        outcome = float(reply[reply.index("score") + 1])
 
-        if outcome == -1:
+        if outcome > 0:
             time.sleep(1.5)
             rageSound.play()
             message = "YOU WIN >:("
-        elif outcome == 0:
-            message = "DRAW"
         else:
-            message = "UNKNOWN OUTCOME"
+            message = "DRAW"
 
         # Clear the canvas and display the message
         canvas.delete("all")
         canvas.create_text(320, 320, text=message, font=("Arial", 48), fill = "red", tags = "message")
     else:
         # Update the board and redraw it
-        board = new_board
+        engine_command("move " + reply[0])
+        board = engine_board()
         drawBoard(canvas, root, board, square_size=80)
 
+        # Think about the expected reply while the player is thinking
+        if reply[2] != "none":
+            engine_command("move " + reply[2])
+            predicted_board = engine_board()
+            engine_command("go ponder depth 4 movetime 60000")
+            pondering = True
+
 def main():
     global board, canvas
     root = tk.Tk()
     root.title("FrostWeb")
 
+    start_engine()
+
     board_size = 8
     square_size = 80  
 
@@ -394,7 +457,7 @@ def main():
         [0, 0, 0, 0, 0, 0, 0, 0],
         [1, 1, 1, 1, 1, 1, 1, 1],
         [4, 2, 3, 5, 6, 3, 2, 4],
-        [0, 0, 1, -1, -1, 0]  # Metadata row
+        [0, 0, 1, -1, -1, 0, 0]  # Metadata row
     ]
 
     drawBoard(canvas, root, board, square_size)
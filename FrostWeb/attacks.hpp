@@ -0,0 +1,137 @@
+/**
+ * @file attacks.hpp
+ * @brief Precomputed attack tables for the chess engine.
+ * 
+ * The tables are bitboards, one bit per square with bit (row * 8 + column) standing for
+ * board[row][column]. They are generated at compile time, so they sit in read-only data
+ * and cost nothing when the engine starts.
+ * 
+ * - knight, king: the squares a knight or king on a square attacks.
+ * - pawn: the squares a pawn of a player on a square attacks (index 1 for white, 0 for black).
+ * - between: the squares strictly between two squares on the same line, otherwise empty.
+ * - line: every square of the line through two squares (including both), otherwise empty.
+ * 
+ * @author Anshuman Routray
+ */
+
+#ifndef ATTACKS_HPP
+#define ATTACKS_HPP
+
+#include <cstdint>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+struct AttackTables {
+    uint64_t knight[64];
+    uint64_t king[64];
+    uint64_t pawn[2][64];
+    uint64_t between[64][64];
+    uint64_t line[64][64];
+};
+
+constexpr bool onBoard(int row, int column){
+    return row >= 0 && row < 8 && column >= 0 && column < 8;
+}
+
+constexpr uint64_t squareBit(int row, int column){
+    return 1ULL << (row * 8 + column);
+}
+
+constexpr AttackTables generateAttackTables(){
+    AttackTables tables{};
+    const int knightSteps[8][2] = {{-2, 1}, {-2, -1}, {2, 1}, {2, -1}, {1, 2}, {1, -2}, {-1, 2}, {-1, -2}};
+    const int kingSteps[8][2] = {{-1, -1}, {-1, 0}, {-1, 1}, {0, -1}, {0, 1}, {1, -1}, {1, 0}, {1, 1}};
+    for(int square = 0; square < 64; square++){
+        int row = square / 8, column = square % 8;
+        for(int i = 0; i < 8; i++){
+            if(onBoard(row + knightSteps[i][0], column + knightSteps[i][1])){
+                tables.knight[square] |= squareBit(row + knightSteps[i][0], column + knightSteps[i][1]);
+            }
+            if(onBoard(row + kingSteps[i][0], column + kingSteps[i][1])){
+                tables.king[square] |= squareBit(row + kingSteps[i][0], column + kingSteps[i][1]);
+            }
+        }
+
+        //White pawns move up the board (towards row 0), black pawns move down
+
+        for(int columnStep = -1; columnStep <= 1; columnStep += 2){
+            if(onBoard(row - 1, column + columnStep)){
+                tables.pawn[1][square] |= squareBit(row - 1, column + columnStep);
+            }
+            if(onBoard(row + 1, column + columnStep)){
+                tables.pawn[0][square] |= squareBit(row + 1, column + columnStep);
+            }
+        }
+
+        //Walking every ray from the square fills in between (on the way) and line (both directions)
+
+        for(int i = 0; i < 8; i++){
+            int rowStep = kingSteps[i][0], columnStep = kingSteps[i][1];
+            uint64_t ray = 0;
+            for(int r = row - rowStep, c = column - columnStep; onBoard(r, c); r -= rowStep, c -= columnStep){
+                ray |= squareBit(r, c);
+            }
+            for(int r = row + rowStep, c = column + columnStep; onBoard(r, c); r += rowStep, c += columnStep){
+                ray |= squareBit(r, c);
+            }
+            uint64_t between = 0;
+            for(int r = row + rowStep, c = column + columnStep; onBoard(r, c); r += rowStep, c += columnStep){
+                tables.between[square][r * 8 + c] = between;
+                tables.line[square][r * 8 + c] = ray | squareBit(row, column);
+                between |= squareBit(r, c);
+            }
+        }
+    }
+    return tables;
+}
+
+inline constexpr AttackTables attackTables = generateAttackTables();
+
+inline constexpr uint64_t knightAttacks(int square){
+    return attackTables.knight[square];
+}
+
+inline constexpr uint64_t kingAttacks(int square){
+    return attackTables.king[square];
+}
+
+inline constexpr uint64_t pawnAttacks(int player, int square){
+    return attackTables.pawn[player > 0 ? 1 : 0][square];
+}
+
+inline constexpr uint64_t betweenSquares(int from, int to){
+    return attackTables.between[from][to];
+}
+
+inline constexpr uint64_t lineSquares(int from, int to){
+    return attackTables.line[from][to];
+}
+
+/**
+ * @brief Removes the lowest set bit of a bitboard and returns its square.
+ */
+inline int popSquare(uint64_t& bits){
+#ifdef _MSC_VER
+    unsigned long square;
+    _BitScanForward64(&square, bits);
+#else
+    int square = __builtin_ctzll(bits);
+#endif
+    bits &= bits - 1;
+    return (int)square;
+}
+
+/**
+ * @brief Returns the number of set bits of a bitboard.
+ */
+inline int bitCount(uint64_t bits){
+#ifdef _MSC_VER
+    return (int)__popcnt64(bits);
+#else
+    return __builtin_popcountll(bits);
+#endif
+}
+
+#endif
@@ -20,6 +20,8 @@
  */
 
 #include "board.hpp"
+#include "attacks.hpp"
+#include "zobrist.hpp"
 
 using namespace std;
 
@@ -45,9 +47,19 @@ const int bothCastlingDisabled = 1;
 const int shortCastlingDisabled = 2;
 const int longCastlingDisabled = 3;
 
+//Packed move meaning there is no move
+
+const int noMove = 0;
+
+//Game States (as reported to the GUI)
+
+const int gameOngoing = 100;
+const int checkmated = -1;
+const int stalemated = 0;
+
 /*Defining starting board, last subArray denotes castling ability for black and white, player's turn, final
-position of last played move, and whether the last move was a double space pawn move(1 for yes, 0 for no) for En Passant
-respectively.*/
+position of last played move, whether the last move was a double space pawn move(1 for yes, 0 for no) for En Passant,
+and the number of half moves since the last capture or pawn move (for the fifty move rule) respectively.*/
 
 const vector<vector<int>> startingBoard = 
     {{-rook, -knight, -bishop, -queen, -king, -bishop, -knight, -rook}, 
@@ -58,7 +70,7 @@ const vector<vector<int>> startingBoard =
      {space, space, space, space, space, space, space, space},
      {pawn, pawn, pawn, pawn, pawn, pawn, pawn, pawn},
      {rook, knight, bishop, queen, king, bishop, knight, rook},
-     {bothCastlingEnabled, bothCastlingEnabled, whitePlayer, -1, -1, 0}};
+     {bothCastlingEnabled, bothCastlingEnabled, whitePlayer, -1, -1, 0, 0}};
 
 pair<int, int> retrieveKingPosition(vector<vector<int>> board, int player){
     pair<int, int> kingPos;
@@ -72,531 +84,575 @@ pair<int, int> retrieveKingPosition(vector<vector<int>> board, int player){
     return kingPos;
 }
 
-vector<vector<int>> playMove(vector<vector<int>> board,
-    pair<int, int> initialPosition, pair<int, int> finalPosition, int promotionPiece, bool enPassant){
-        int player = board[8][2];
-        int castlingState = (player == blackPlayer) ? (0) : (1);
-        int piece = abs(board[initialPosition.first][initialPosition.second]);
-        board[initialPosition.first][initialPosition.second] = space;
-        board[finalPosition.first][finalPosition.second] = piece * player;
-        board[8][3] = finalPosition.first;
-        board[8][4] = finalPosition.second;
-        board[8][5] = 0;
-        if(enPassant){
-            board[initialPosition.first][finalPosition.second] = space;
-        }
-        else if(promotionPiece != 0){
-            board[finalPosition.first][finalPosition.second] = promotionPiece * player;
-        }
+//Properties of each player that are known at compile time, so the move generation never multiplies by the player
 
-        if(piece == pawn && abs(finalPosition.first - initialPosition.first) == 2){
-            board[8][5] = 1;
-        }
-        else if(piece == king){
-            board[8][castlingState] = bothCastlingDisabled;
-            if(finalPosition.second - initialPosition.second == 2){
-                board[initialPosition.first][5] = rook;
-                board[initialPosition.first][7] = space;
-            }
-            else if(finalPosition.second - initialPosition.second == -2){
-                board[initialPosition.first][3] = rook;
-                board[initialPosition.first][0] = space;
-            }
-        }
-        else if(piece == rook && board[8][castlingState] != bothCastlingDisabled){
+template<Color Us> constexpr Color opponent = (Us == White) ? Black : White;
+template<Color Us> constexpr int pawnStep = (Us == White) ? -1 : 1;      //row change of a pawn move
+template<Color Us> constexpr int homeRow = (Us == White) ? 7 : 0;        //row of the king and rooks
+template<Color Us> constexpr int pawnRow = (Us == White) ? 6 : 1;        //row pawns start on
+template<Color Us> constexpr int promotionRow = (Us == White) ? 1 : 6;   //row pawns promote from
+template<Color Us> constexpr int castlingSlot = (Us == White) ? 1 : 0;   //metadata entry of the castling state
 
-            // floor(3.5 + 3.5 * player) returns the row of the King depending on Black or White
+template<Color Us> constexpr int own(int pieceType){
+    return (Us == White) ? pieceType : -pieceType;
+}
 
-            if(initialPosition.first == floor(3.5 + 3.5 * player) && initialPosition.second == 0){
-                board[8][castlingState] = 
-                    (board[8][castlingState] == shortCastlingDisabled) ? bothCastlingDisabled : longCastlingDisabled;
-            }
-            else if(initialPosition.first == floor(3.5 + 3.5 * player) && initialPosition.second == 7){
-                board[8][castlingState] = 
-                    (board[8][castlingState] == longCastlingDisabled) ? bothCastlingDisabled : shortCastlingDisabled;
-            }
-        }
+template<Color Us> constexpr bool isOwn(int piece){
+    return (Us == White) ? piece > 0 : piece < 0;
+}
 
-    //Checking if move is an illegal move, if true then returning an empty board
+template<Color Us> constexpr bool isEnemy(int piece){
+    return (Us == White) ? piece < 0 : piece > 0;
+}
 
-    //Finding Position of Kings
+//Directions of sliding pieces, the first four are diagonals and the last four are lines
 
-    pair<int, int> whiteKingPos = {0, 0};
-    pair<int, int> blackKingPos = {0, 0};
+static const int slidingSteps[8][2] = {{-1, 1}, {-1, -1}, {1, 1}, {1, -1}, {-1, 0}, {1, 0}, {0, 1}, {0, -1}};
 
-    for(int r = 0; r < 8; r++){
-        for(int c = 0; c < 8; c++){
-            if(board[r][c] == king){
-                whiteKingPos = {r, c};
-            }
-            else if(board[r][c] == -king){
-                blackKingPos = {r, c};
-            }
-        }
-    } 
+/**
+ * @brief Removes one side from a castling state.
+ * 
+ * @param castlingState The current castling state.
+ * 
+ * @param disabledSide shortCastlingDisabled or longCastlingDisabled.
+ * 
+ * @return The new castling state.
+ */
+static int removeCastling(int castlingState, int disabledSide){
+    if(castlingState == bothCastlingEnabled || castlingState == disabledSide){
+        return disabledSide;
+    }
+    return bothCastlingDisabled;
+}
 
-    if(player == whitePlayer){
+template<Color Us>
+static bool isAttackedFor(const vector<vector<int>>& board, pair<int, int> position, bool anyAttack);
 
-        //If white can attack black's king, then the previous move was illegal
+/**
+ * @brief Plays a move of Us without checking if it leaves the king in check.
+ */
+template<Color Us>
+static vector<vector<int>> applyMoveFor(vector<vector<int>> board,
+    pair<int, int> initialPosition, pair<int, int> finalPosition, int promotionPiece, bool enPassant){
+    int piece = abs(board[initialPosition.first][initialPosition.second]);
+    bool capture = enPassant || board[finalPosition.first][finalPosition.second] != space;
+    board[8][6] = (piece == pawn || capture) ? 0 : board[8][6] + 1;
+    board[initialPosition.first][initialPosition.second] = space;
+    board[finalPosition.first][finalPosition.second] = own<Us>(piece);
+    board[8][3] = finalPosition.first;
+    board[8][4] = finalPosition.second;
+    board[8][5] = 0;
+    if(enPassant){
+        board[initialPosition.first][finalPosition.second] = space;
+    }
+    else if(promotionPiece != 0){
+        board[finalPosition.first][finalPosition.second] = own<Us>(promotionPiece);
+    }
 
-        if(isAttacked(board, whiteKingPos)){
-            return {};
+    if(piece == pawn && abs(finalPosition.first - initialPosition.first) == 2){
+        board[8][5] = 1;
+    }
+    else if(piece == king){
+        board[8][castlingSlot<Us>] = bothCastlingDisabled;
+        if(finalPosition.second - initialPosition.second == 2){
+            board[initialPosition.first][5] = own<Us>(rook);
+            board[initialPosition.first][7] = space;
+        }
+        else if(finalPosition.second - initialPosition.second == -2){
+            board[initialPosition.first][3] = own<Us>(rook);
+            board[initialPosition.first][0] = space;
+        }
+    }
+    else if(piece == rook && initialPosition.first == homeRow<Us>){
+        if(initialPosition.second == 0){
+            board[8][castlingSlot<Us>] = removeCastling(board[8][castlingSlot<Us>], longCastlingDisabled);
+        }
+        else if(initialPosition.second == 7){
+            board[8][castlingSlot<Us>] = removeCastling(board[8][castlingSlot<Us>], shortCastlingDisabled);
         }
     }
-    else {
 
-        //If black can attack white's king, then the previous move was illegal
+    //Capturing a rook in its corner takes away that side's castling
 
-        if(isAttacked(board, blackKingPos)){
-            return {};
+    if(capture && finalPosition.first == homeRow<opponent<Us>>){
+        constexpr int slot = castlingSlot<opponent<Us>>;
+        if(finalPosition.second == 0){
+            board[8][slot] = removeCastling(board[8][slot], longCastlingDisabled);
+        }
+        else if(finalPosition.second == 7){
+            board[8][slot] = removeCastling(board[8][slot], shortCastlingDisabled);
         }
     }
 
-    board[8][2] = -player;
+    board[8][2] = opponent<Us>;
 
     return board;
 }
 
-bool isAttacked(vector<vector<int>> board, pair<int, int> position){
-    int row = position.first;
-    int column = position.second;
-    int player = board[8][2];
-    int piece = abs(board[row][column]);
-    board[8][2] = -player;
-    //upper right diagonal
-
-    int rowChange = row - 1, columnChange = column + 1;
-    while(rowChange >= 0 && columnChange < 8 && 
-        board[rowChange][columnChange] * player <= 0){
-        if(board[rowChange][columnChange] == -(bishop * player)
-            || board[rowChange][columnChange] == -(queen * player)){
-            if(piece != king && playMove(board, {rowChange, columnChange}, position, 0, false).empty()){
-                break;
-            }
-            else {
-                return true;
-            }
-        }
-        else if(board[rowChange][columnChange] != space){
-            break;
-        }
-        rowChange--, columnChange++;
-    }
+template<Color Us>
+static vector<vector<int>> playMoveFor(const vector<vector<int>>& currentBoard,
+    pair<int, int> initialPosition, pair<int, int> finalPosition, int promotionPiece, bool enPassant){
+    vector<vector<int>> board = applyMoveFor<Us>(currentBoard, initialPosition, finalPosition, promotionPiece, enPassant);
 
-    //upper left diagonal
+    //Checking if move is an illegal move (own king left under attack), if true then returning an empty board
 
-    rowChange = row - 1, columnChange = column - 1;
-    while(rowChange >= 0 && columnChange >= 0 && 
-        board[rowChange][columnChange] * player <= 0){
-        if(board[rowChange][columnChange] == -(bishop * player)
-            || board[rowChange][columnChange] == -(queen * player)){
-            if(piece != king && playMove(board, {rowChange, columnChange}, position, 0, false).empty()){
-                break;
-            }
-            else {
-                return true;
+    pair<int, int> kingPos = {0, 0};
+    for(int r = 0; r < 8; r++){
+        for(int c = 0; c < 8; c++){
+            if(board[r][c] == own<Us>(king)){
+                kingPos = {r, c};
             }
         }
-        else if(board[rowChange][columnChange] != space){
-            break;
-        }
-        rowChange--, columnChange--;
+    }
+    if(isAttackedFor<Us>(board, kingPos, true)){
+        return {};
     }
 
-    //bottom right diagonal
+    return board;
+}
 
-    rowChange = row + 1, columnChange = column + 1;
-    while(rowChange < 8 && columnChange < 8 && 
-        board[rowChange][columnChange] * player <= 0){
-        if(board[rowChange][columnChange] == -(bishop * player)
-            || board[rowChange][columnChange] == -(queen * player)){
-            if(piece != king && playMove(board, {rowChange, columnChange}, position, 0, false).empty()){
-                break;
-            }
-            else {
-                return true;
-            }
-        }
-        else if(board[rowChange][columnChange] != space){
-            break;
-        }
-        rowChange++, columnChange++;
+vector<vector<int>> playMove(vector<vector<int>> board,
+    pair<int, int> initialPosition, pair<int, int> finalPosition, int promotionPiece, bool enPassant){
+    if(board[8][2] == whitePlayer){
+        return playMoveFor<White>(board, initialPosition, finalPosition, promotionPiece, enPassant);
     }
+    return playMoveFor<Black>(board, initialPosition, finalPosition, promotionPiece, enPassant);
+}
 
-    //bottom left diagonal
-
-    rowChange = row + 1, columnChange = column - 1;
-    while(rowChange < 8 && columnChange >= 0 && 
-        board[rowChange][columnChange] * player <= 0){
-        if(board[rowChange][columnChange] == -(bishop * player)
-            || board[rowChange][columnChange] == -(queen * player)){
-            if(piece != king && playMove(board, {rowChange, columnChange}, position, 0, false).empty()){
+/**
+ * @brief Checks if the opponent of Us attacks a square.
+ * 
+ * @param anyAttack If false, attackers other than the king only count if capturing on the
+ * square would be a legal move for them. Attacks on the king and on the squares it passes
+ * while castling always count.
+ */
+template<Color Us>
+static bool isAttackedFor(const vector<vector<int>>& board, pair<int, int> position, bool anyAttack){
+    constexpr Color Them = opponent<Us>;
+    int row = position.first;
+    int column = position.second;
+    auto counts = [&](int fromRow, int fromColumn){
+        return anyAttack || !playMoveFor<Them>(board, {fromRow, fromColumn}, position, 0, false).empty();
+    };
+
+    //Diagonals (bishops and queens) and lines (rooks and queens)
+
+    for(int direction = 0; direction < 8; direction++){
+        int slider = (direction < 4) ? bishop : rook;
+        int rowChange = row + slidingSteps[direction][0], columnChange = column + slidingSteps[direction][1];
+        while(onBoard(rowChange, columnChange) && !isOwn<Us>(board[rowChange][columnChange])){
+            int attacker = board[rowChange][columnChange];
+            if(attacker == own<Them>(slider) || attacker == own<Them>(queen)){
+                if(counts(rowChange, columnChange)){
+                    return true;
+                }
                 break;
             }
-            else {
-                return true;
+            else if(attacker != space){
+                break;
             }
+            rowChange += slidingSteps[direction][0], columnChange += slidingSteps[direction][1];
         }
-        else if(board[rowChange][columnChange] != space){
-            break;
-        }
-        rowChange++, columnChange--;
     }
 
-    //upper line
+    //Knight, pawn and king attacks come from the precomputed tables
 
-    rowChange = row - 1, columnChange = column;
-    while(rowChange >= 0 && board[rowChange][columnChange] * player <= 0){
-        if(board[rowChange][columnChange] == -(rook * player) || 
-        board[rowChange][columnChange] == -(queen * player)){
-            if(piece != king && playMove(board, {rowChange, columnChange}, position, 0, false).empty()){
-                break;
-            }
-            else {
-                return true;
-            }
-        }
-        else if(board[rowChange][columnChange] != space){
-            break;
+    int square = row * 8 + column;
+
+    uint64_t knightSquares = knightAttacks(square);
+    while(knightSquares){
+        int from = popSquare(knightSquares);
+        if(board[from / 8][from % 8] == own<Them>(knight) && counts(from / 8, from % 8)){
+            return true;
         }
-        rowChange--;
     }
 
-    //bottom line
+    //A pawn of Us on the square attacks exactly the squares an enemy pawn attacks it from
 
-    rowChange = row + 1, columnChange = column;
-    while(rowChange < 8 && board[rowChange][columnChange] * player <= 0){
-        if(board[rowChange][columnChange] == -(rook * player) || 
-        board[rowChange][columnChange] == -(queen * player)){
-            if(piece != king && playMove(board, {rowChange, columnChange}, position, 0, false).empty()){
-                break;
-            }
-            else {
-                return true;
-            }
-        }
-        else if(board[rowChange][columnChange] != space){
-            break;
+    uint64_t pawnSquares = pawnAttacks(Us, square);
+    while(pawnSquares){
+        int from = popSquare(pawnSquares);
+        if(board[from / 8][from % 8] == own<Them>(pawn) && counts(from / 8, from % 8)){
+            return true;
         }
-        rowChange++;
     }
 
-    //right line
-
-    rowChange = row, columnChange = column + 1;
-    while(columnChange < 8 && board[rowChange][columnChange] * player <= 0){
-        if(board[rowChange][columnChange] == -(rook * player) || 
-        board[rowChange][columnChange] == -(queen * player)){
-            if(piece != king && playMove(board, {rowChange, columnChange}, position, 0, false).empty()){
-                break;
-            }
-            else {
-                return true;
-            }
-        }
-        else if(board[rowChange][columnChange] != space){
-            break;
+    uint64_t kingSquares = kingAttacks(square);
+    while(kingSquares){
+        int from = popSquare(kingSquares);
+        if(board[from / 8][from % 8] == own<Them>(king) && counts(from / 8, from % 8)){
+            return true;
         }
-        columnChange++;
     }
+    return false;
+}
 
-    //left line
+bool isAttacked(const vector<vector<int>> board, pair<int, int> position){
+    bool anyAttack = abs(board[position.first][position.second]) == king;
+    if(board[8][2] == whitePlayer){
+        return isAttackedFor<White>(board, position, anyAttack);
+    }
+    return isAttackedFor<Black>(board, position, anyAttack);
+}
 
-    rowChange = row, columnChange = column - 1;
-    while(columnChange >= 0 && board[rowChange][columnChange] * player <= 0){
-        if(board[rowChange][columnChange] == -(rook * player) || 
-        board[rowChange][columnChange] == -(queen * player)){
-            if(piece != king && playMove(board, {rowChange, columnChange}, position, 0, false).empty()){
+/**
+ * @brief Returns the squares a sliding piece attacks, stopping at (and including) the first blocker.
+ */
+static uint64_t slidingAttacks(int square, int firstDirection, int lastDirection, uint64_t blockers){
+    uint64_t attacks = 0;
+    for(int direction = firstDirection; direction < lastDirection; direction++){
+        int rowChange = square / 8 + slidingSteps[direction][0], columnChange = square % 8 + slidingSteps[direction][1];
+        while(onBoard(rowChange, columnChange)){
+            attacks |= squareBit(rowChange, columnChange);
+            if(blockers & squareBit(rowChange, columnChange)){
                 break;
             }
-            else {
-                return true;
-            }
+            rowChange += slidingSteps[direction][0], columnChange += slidingSteps[direction][1];
         }
-        else if(board[rowChange][columnChange] != space){
-            break;
-        }
-        columnChange--;
     }
+    return attacks;
+}
 
-    //All possible squares a knight can attack from
-
-    vector<pair<int, int>> possibleKnightMoves = {{row - 2, column + 1}, {row - 2, column - 1}, 
-        {row + 2, column + 1}, {row + 2, column - 1}, {row + 1, column + 2}, {row + 1, column - 2},
-        {row - 1, column + 2}, {row - 1, column - 2}};
-    for(pair<int, int> move : possibleKnightMoves){
-        if(move.first < 8 && move.first >= 0 && move.second < 8 && move.second >= 0 && 
-            board[move.first][move.second] == -(knight * player)){
-            if(piece != king && playMove(board, {move.first, move.second}, position, 0, false).empty()){
-                break;
+static AttackInfo computeAttackInfo(const vector<vector<int>>& board){
+    AttackInfo info = {{0, 0}, 0, 0, {-1, -1}};
+    int us = (board[8][2] == whitePlayer) ? 1 : 0;
+    uint64_t occupied[2] = {0, 0};
+    for(int square = 0; square < 64; square++){
+        int piece = board[square / 8][square % 8];
+        if(piece != space){
+            occupied[piece > 0] |= 1ULL << square;
+            if(abs(piece) == king){
+                info.kingSquare[piece > 0] = square;
             }
-            else {
-                return true;
+        }
+    }
+    uint64_t allPieces = occupied[0] | occupied[1];
+    uint64_t ownKing = (info.kingSquare[us] >= 0) ? (1ULL << info.kingSquare[us]) : 0;
+    for(int square = 0; square < 64; square++){
+        int piece = board[square / 8][square % 8];
+        if(piece == space){
+            continue;
+        }
+        int side = piece > 0;
+        int enemyKing = info.kingSquare[!side];
+        uint64_t blockers = allPieces & ~((enemyKing >= 0) ? (1ULL << enemyKing) : 0);
+        uint64_t attacks = 0;
+        switch(abs(piece)){
+            case pawn: attacks = pawnAttacks(piece, square); break;
+            case knight: attacks = knightAttacks(square); break;
+            case bishop: attacks = slidingAttacks(square, 0, 4, blockers); break;
+            case rook: attacks = slidingAttacks(square, 4, 8, blockers); break;
+            case queen: attacks = slidingAttacks(square, 0, 8, blockers); break;
+            case king: attacks = kingAttacks(square); break;
+        }
+        info.attacked[side] |= attacks;
+        if(side != us && (attacks & ownKing)){
+            info.checkers |= 1ULL << square;
+        }
+
+        //An own piece alone between the king and an enemy slider on its line is pinned
+
+        int kingSquare = info.kingSquare[us];
+        int pieceType = abs(piece);
+        if(side != us && kingSquare >= 0 && (pieceType == bishop || pieceType == rook || pieceType == queen) &&
+            lineSquares(kingSquare, square)){
+            bool straight = kingSquare / 8 == square / 8 || kingSquare % 8 == square % 8;
+            uint64_t between = betweenSquares(kingSquare, square) & allPieces;
+            if(((straight && pieceType != bishop) || (!straight && pieceType != rook)) &&
+                between && !(between & (between - 1)) && (between & occupied[us])){
+                info.pinned |= between;
             }
         }
     }
+    return info;
+}
 
-    //Pawn Attacks
+//One cached position per thread, recognised by its Zobrist key
 
-    if(player == blackPlayer){
-        if(row < 7 && column > 0 && board[row + 1][column - 1] == pawn && 
-           piece != king && !playMove(board, {row + 1, column - 1}, position, 0, false).empty()){
-            return true;
-        }
-        else if(row < 7 && column < 7 && board[row + 1][column + 1] == pawn && 
-            piece != king && !playMove(board, {row + 1, column + 1}, position, 0, false).empty()){
-            return true;
-        }
-    }
-    else {
-        if(row > 0 && column < 7 && board[row - 1][column + 1] == -pawn && 
-            piece != king && !playMove(board, {row - 1, column + 1}, position, 0, false).empty()){
-            return true;
-        }
-        else if(row > 0 && column > 0 && board[row - 1][column - 1] == -pawn && 
-            piece != king && !playMove(board, {row - 1, column - 1}, position, 0, false).empty()) {
-            return true;
-        }
-    }
+struct AttackCache {
+    uint64_t key = 0;
+    bool valid = false;
+    AttackInfo info;
+};
 
-    //King Attacks
+static thread_local AttackCache attackCache;
 
-    for(int i = row - 1; i <= row + 1; i++){
-        for(int j = column - 1; j <= column + 1; j++){
-            if(i >= 0 && i < 8 && j >= 0 && j < 8 && board[i][j] == (king * player)){
-                return false;
-            }
-            if(i >= 0 && i < 8 && j >= 0 && j < 8 && board[i][j] == -(king * player)){
-                if(!playMove(board, {i, j}, position, 0, false).empty()){
-                    return true;
-                }
-            }
-        }
+const AttackInfo& attackInfo(const vector<vector<int>>& board){
+    uint64_t key = zobristKey(board);
+    if(!attackCache.valid || attackCache.key != key){
+        attackCache.info = computeAttackInfo(board);
+        attackCache.key = key;
+        attackCache.valid = true;
     }
-    return false;
+    return attackCache.info;
 }
 
-vector<vector<vector<int>>> generateMoves(vector<vector<int>> board){
-    vector<vector<vector<int>>> moveList;
-    int player = board[8][2];
+/**
+ * @brief Walks through every move of Us and hands each resulting board to a visitor.
+ *
+ * Moves that leave the king in check are handed over as empty boards. The visitor returns true
+ * to stop the walk early.
+ *
+ * @return True if the visitor stopped the walk, otherwise false.
+ */
+template<Color Us, typename Visitor>
+static bool visitMovesFor(const vector<vector<int>>& board, Visitor& visit){
+    pair<int, int> previousMove = {board[8][3], board[8][4]};
+
+    //Most moves are proven legal from the cached attack information, only the rest are played out and checked.
+    //Moves known to be illegal are skipped without being handed to the visitor.
+
+    AttackInfo info = attackInfo(board);
+    int kingSquare = info.kingSquare[Us == White];
+    uint64_t enemyAttacks = info.attacked[Us != White];
+    auto tryMove = [&](pair<int, int> from, pair<int, int> to, int promotionPiece, bool enPassant){
+        int fromSquare = from.first * 8 + from.second;
+        uint64_t toBit = squareBit(to.first, to.second);
+        if(fromSquare == kingSquare){
+            return !(enemyAttacks & toBit) && visit(applyMoveFor<Us>(board, from, to, promotionPiece, enPassant));
+        }
+        if(info.checkers || enPassant || kingSquare < 0){
+            return visit(playMoveFor<Us>(board, from, to, promotionPiece, enPassant));
+        }
+        if((info.pinned & (1ULL << fromSquare)) && !(lineSquares(kingSquare, fromSquare) & toBit)){
+            return false;
+        }
+        return visit(applyMoveFor<Us>(board, from, to, promotionPiece, enPassant));
+    };
     for(int row = 0; row < 8; row++){
         for(int column = 0; column < 8; column++){
             int piece = board[row][column];
-            pair<int, int> previousMove = {board[8][3], board[8][4]};
-            if(player * piece > 0){              
-                if(abs(piece) == pawn){
-                    //Checking for promotion ability of pawn, else checks through normal pawn movements
-
-                    if((player == whitePlayer && row == 1) || (player == blackPlayer && row == 6)){
-                        //Going through all possible promotion options, and all possible movement of pawn
-
-                        for(int promoteTo = queen; promoteTo >= knight; promoteTo--){
-                            if(board[row - player][column] == space){
-                            moveList.push_back(playMove(board, {row, column}, 
-                                {row - player, column}, promoteTo, false));
-                            }
-                            if(column < 7 && board[row - player][column + 1] * player < 0){
-                            moveList.push_back(playMove(board, {row, column}, 
-                                {row - player, column + 1}, promoteTo, false));
-                            }
-                            if(column > 0 && board[row - player][column - 1] * player < 0){
-                            moveList.push_back(playMove(board, {row, column}, 
-                                {row - player, column - 1}, promoteTo, false));
-                            }
+            if(!isOwn<Us>(piece)){
+                continue;
+            }
+            int pieceType = abs(piece);
+            if(pieceType == pawn){
+                int nextRow = row + pawnStep<Us>;
+                if(row == promotionRow<Us>){
+
+                    //Going through all possible promotion options, and all possible movement of pawn
+
+                    for(int promoteTo = queen; promoteTo >= knight; promoteTo--){
+                        if(board[nextRow][column] == space &&
+                            tryMove({row, column}, {nextRow, column}, promoteTo, false)){
+                            return true;
                         }
-                    }
-                    else{
-                        //Normal Movement of Pawn
-                        if(board[row - player][column] == space){
-                            moveList.push_back(playMove(board, {row, column}, 
-                                {row - player, column}, 0, false)); //PROBLEMATIC!! WHY???
+                        if(column < 7 && isEnemy<Us>(board[nextRow][column + 1]) &&
+                            tryMove({row, column}, {nextRow, column + 1}, promoteTo, false)){
+                            return true;
+                        }
+                        if(column > 0 && isEnemy<Us>(board[nextRow][column - 1]) &&
+                            tryMove({row, column}, {nextRow, column - 1}, promoteTo, false)){
+                            return true;
                         }
-                        if(row - player < 7 && row - player > 0 && column > 0 && board[row - player][column - 1] * player < 0){
-                            moveList.push_back(playMove(board, {row, column}, 
-                                {row - player, column - 1}, 0, false));
-                        } 
-                        if(row - player < 7 && row - player > 0 && column < 7 && board[row - player][column + 1] * player < 0){
-                            moveList.push_back(playMove(board, {row, column}, 
-                                {row - player, column + 1}, 0, false));
-                        }   
                     }
-                    //En Passant and Double Space Pawn Move Respectively
+                }
+                else {
 
-                    if(board[8][5] == 1 && previousMove.first == row && abs(previousMove.second - column) == 1){
-                        moveList.push_back(playMove(board, {row, column}, 
-                            {previousMove.first - player, previousMove.second}, 0, true));
+                    //Normal Movement of Pawn
+
+                    if(board[nextRow][column] == space &&
+                        tryMove({row, column}, {nextRow, column}, 0, false)){
+                        return true;
                     }
-                    if(((player == whitePlayer && row == 6) || (player == blackPlayer && row == 1)) && 
-                        board[row - player * 2][column] == space && board[row - player][column] == space){
-                        moveList.push_back(playMove(board, {row, column}, 
-                            {row - player * 2, column}, 0, false));
+                    if(column > 0 && isEnemy<Us>(board[nextRow][column - 1]) &&
+                        tryMove({row, column}, {nextRow, column - 1}, 0, false)){
+                        return true;
                     }
-                }         
-                else if(abs(piece) == knight){
-
-                    //All possible squares a knight can move to
-
-                    vector<pair<int, int>> possibleKnightMoves = {{row - 2, column + 1}, {row - 2, column - 1}, 
-                        {row + 2, column + 1}, {row + 2, column - 1}, {row + 1, column + 2}, {row + 1, column - 2},
-                        {row - 1, column + 2}, {row - 1, column - 2}};
-                    for(pair<int, int> move : possibleKnightMoves){
-                        if(move.first < 8 && move.first >= 0 && move.second < 8 && move.second >= 0 && 
-                            board[move.first][move.second] * player <= 0){
-                            moveList.push_back(playMove(board, {row, column}, 
-                                {move.first, move.second}, 0, false));
-                        }
+                    if(column < 7 && isEnemy<Us>(board[nextRow][column + 1]) &&
+                        tryMove({row, column}, {nextRow, column + 1}, 0, false)){
+                        return true;
                     }
                 }
-                if(abs(piece) == bishop || abs(piece) == queen){
-                    
-                    //upper right diagonal for bishop or queen
-
-                    int rowChange = row - 1, columnChange = column + 1;
-                    while(rowChange >= 0 && columnChange < 8 && 
-                        board[rowChange][columnChange] * player <= 0){
-                        moveList.push_back(playMove(board, {row, column}, 
-                            {rowChange, columnChange}, 0, false));
-                        if(board[rowChange][columnChange] * player < 0){
-                            break;
-                        }
-                        rowChange--, columnChange++;
-                    }
 
-                    //upper left diagonal for bishop or queen
+                //En Passant and Double Space Pawn Move Respectively
 
-                    rowChange = row - 1, columnChange = column - 1;
-                    while(rowChange >= 0 && columnChange >= 0 && 
-                        board[rowChange][columnChange] * player <= 0){
-                        moveList.push_back(playMove(board, {row, column}, 
-                            {rowChange, columnChange}, 0, false));
-                        if(board[rowChange][columnChange] * player < 0){
-                            break;
-                        }
-                        rowChange--, columnChange--;
-                    }
+                if(board[8][5] == 1 && previousMove.first == row && abs(previousMove.second - column) == 1 &&
+                    tryMove({row, column}, {nextRow, previousMove.second}, 0, true)){
+                    return true;
+                }
+                if(row == pawnRow<Us> && board[nextRow][column] == space && board[nextRow + pawnStep<Us>][column] == space &&
+                    tryMove({row, column}, {nextRow + pawnStep<Us>, column}, 0, false)){
+                    return true;
+                }
+            }
+            else if(pieceType == knight){
 
-                    //bottom right diagonal for bishop or queen
+                //All possible squares a knight can move to
 
-                    rowChange = row + 1, columnChange = column + 1;
-                    while(rowChange < 8 && columnChange < 8 && 
-                        board[rowChange][columnChange] * player <= 0){
-                        moveList.push_back(playMove(board, {row, column}, 
-                            {rowChange, columnChange}, 0, false));
-                        if(board[rowChange][columnChange] * player < 0){
-                            break;
-                        }
-                        rowChange++, columnChange++;
+                uint64_t knightSquares = knightAttacks(row * 8 + column);
+                while(knightSquares){
+                    int to = popSquare(knightSquares);
+                    if(!isOwn<Us>(board[to / 8][to % 8]) &&
+                        tryMove({row, column}, {to / 8, to % 8}, 0, false)){
+                        return true;
                     }
+                }
+            }
+            else if(pieceType == king){
 
-                    //bottom left diagonal for bishop or queen
+                //looping through all possible King Moves
 
-                    rowChange = row + 1, columnChange = column - 1;
-                    while(rowChange < 8 && columnChange >= 0 && 
-                        board[rowChange][columnChange] * player <= 0){
-                        moveList.push_back(playMove(board, {row, column}, 
-                            {rowChange, columnChange}, 0, false));
-                        if(board[rowChange][columnChange] * player < 0){
-                            break;
-                        }
-                        rowChange++, columnChange--;
+                uint64_t kingSquares = kingAttacks(row * 8 + column);
+                while(kingSquares){
+                    int to = popSquare(kingSquares);
+                    if(!isOwn<Us>(board[to / 8][to % 8]) &&
+                        tryMove({row, column}, {to / 8, to % 8}, 0, false)){
+                        return true;
                     }
                 }
-                if(abs(piece) == rook || abs(piece) == queen){
 
-                    //upper line for rook or queen
+                //Castling, the king may not be in check or pass through an attacked square
 
-                    int rowChange = row - 1, columnChange = column;
-                    while(rowChange >= 0 && board[rowChange][columnChange] * player <= 0){
-                        moveList.push_back(playMove(board, {row, column}, 
-                            {rowChange, columnChange}, 0, false));
-                        if(board[rowChange][columnChange] * player < 0){
-                            break;
-                        }
-                        rowChange--;
-                    }
+                int castlingState = board[8][castlingSlot<Us>];
+                if(row != homeRow<Us> || column != 4 || castlingState == bothCastlingDisabled){
+                    continue;
+                }
 
-                    //bottom line for rook or queen
+                //Short Castling
 
-                    rowChange = row + 1, columnChange = column;
-                    while(rowChange < 8 && board[rowChange][columnChange] * player <= 0){
-                        moveList.push_back(playMove(board, {row, column}, 
-                            {rowChange, columnChange}, 0, false));
-                        if(board[rowChange][columnChange] * player < 0){
-                            break;
-                        }
-                        rowChange++;
-                    }
+                if(castlingState != shortCastlingDisabled && board[row][5] == space && board[row][6] == space &&
+                    board[row][7] == own<Us>(rook) && !(enemyAttacks & (squareBit(row, 4) | squareBit(row, 5) | squareBit(row, 6))) &&
+                    tryMove({row, column}, {row, 6}, 0, false)){
+                    return true;
+                }
 
-                    //right line for rook or queen
+                //Long Castling
 
-                    rowChange = row, columnChange = column + 1;
-                    while(columnChange < 8 && board[rowChange][columnChange] * player <= 0){
-                        moveList.push_back(playMove(board, {row, column}, 
-                            {rowChange, columnChange}, 0, false));
-                        if(board[rowChange][columnChange] * player < 0){
-                            break;
-                        }
-                        columnChange++;
-                    }
+                if(castlingState != longCastlingDisabled && board[row][3] == space && board[row][2] == space &&
+                    board[row][1] == space && board[row][0] == own<Us>(rook) &&
+                    !(enemyAttacks & (squareBit(row, 4) | squareBit(row, 3) | squareBit(row, 2))) &&
+                    tryMove({row, column}, {row, 2}, 0, false)){
+                    return true;
+                }
+            }
+            else {
 
-                    //left line for rook or queen
+                //Bishops slide along the diagonals, rooks along the lines and queens along both
 
-                    rowChange = row, columnChange = column - 1;
-                    while(columnChange >= 0 && board[rowChange][columnChange] * player <= 0){
-                        moveList.push_back(playMove(board, {row, column}, 
-                            {rowChange, columnChange}, 0, false));
-                        if(board[rowChange][columnChange] * player < 0){
+                int firstDirection = (pieceType == rook) ? 4 : 0;
+                int lastDirection = (pieceType == bishop) ? 4 : 8;
+                for(int direction = firstDirection; direction < lastDirection; direction++){
+                    int rowChange = row + slidingSteps[direction][0], columnChange = column + slidingSteps[direction][1];
+                    while(onBoard(rowChange, columnChange) && !isOwn<Us>(board[rowChange][columnChange])){
+                        if(tryMove({row, column}, {rowChange, columnChange}, 0, false)){
+                            return true;
+                        }
+                        if(isEnemy<Us>(board[rowChange][columnChange])){
                             break;
                         }
-                        columnChange--;
+                        rowChange += slidingSteps[direction][0], columnChange += slidingSteps[direction][1];
                     }
                 }
-                else if(abs(piece) == king){
+            }
+        }
+    }
+    return false;
+}
 
-            
-                    //looping through all possible King Moves
+/**
+ * @brief Picks the move generation specialised for the player to move.
+ */
+template<typename Visitor>
+static bool visitMoves(const vector<vector<int>>& board, Visitor visit){
+    if(board[8][2] == whitePlayer){
+        return visitMovesFor<White>(board, visit);
+    }
+    return visitMovesFor<Black>(board, visit);
+}
 
-                    for(int i = row - 1; i <= row + 1; i++){
-                        for(int j = column - 1; j <= column + 1; j++){
-                            if(i >= 0 && i < 8 && j >= 0 && j < 8 && board[i][j] * player <= 0){
-                                moveList.push_back(playMove(board, {row, column}, {i, j}, 0, false));
-                            }
-                        }
-                    }
+vector<vector<vector<int>>> generateMoves(vector<vector<int>> board){
 
-                    //Short Castling
-                    
-                    int castlingState = board[8][floor(0.5 + player)];
+    //Keeping only the legal moves (illegal moves come back as empty boards)
 
-                    if(!(castlingState == shortCastlingDisabled || castlingState == bothCastlingDisabled) &&
-                        board[row][column + 1] == space && board[row][column + 2] == space && 
-                        !isAttacked(board, {row, column}) && !isAttacked(board, {row, column + 1}) && 
-                        !isAttacked(board, {row, column + 2}) && board[row][7] == 4){
-                        moveList.push_back(playMove(board, {row, column}, {row, column + 2}, 0, false));
-                    }
+    vector<vector<vector<int>>> legalMoveList;
+    legalMoveList.reserve(50);
+    visitMoves(board, [&legalMoveList](vector<vector<int>> newBoard){
+        if(!newBoard.empty()){
+            legalMoveList.push_back(std::move(newBoard));
+        }
+        return false;
+    });
+    return legalMoveList;
+}
 
-                    //Long Castling
+bool hasLegalMove(const vector<vector<int>> board){
 
-                    if(!(castlingState == longCastlingDisabled || castlingState == bothCastlingDisabled) &&
-                        board[row][column - 1] == space && board[row][column - 2] == space && 
-                        board[row][column - 3] == space && !isAttacked(board, {row, column}) &&
-                        !isAttacked(board, {row, column - 1}) && !isAttacked(board, {row, column - 2}) &&
-                        !isAttacked(board, {row, column - 3}) && board[row][0] == 4){
-                        moveList.push_back(playMove(board, {row, column}, {row, column - 2}, 0, false));
-                    }                   
-                }   
+    //Stopping at the first move that does not come back as an empty board
+
+    return visitMoves(board, [](const vector<vector<int>>& newBoard){
+        return !newBoard.empty();
+    });
+}
+
+bool isInCheck(const vector<vector<int>> board){
+    return attackInfo(board).checkers != 0;
+}
+
+int gameStatus(const vector<vector<int>> board){
+    if(hasLegalMove(board)){
+        return gameOngoing;
+    }
+    return isInCheck(board) ? checkmated : stalemated;
+}
+//Square names, row 0 is the eighth rank
+
+static string squareName(int row, int col){
+    return string(1, (char)('a' + col)) + (char)('8' - row);
+}
+
+int encodeMove(const vector<vector<int>>& before, const vector<vector<int>>& after){
+    int player = before[8][2];
+    int fromRow = -1, fromCol = -1, toRow = -1, toCol = -1;
+    for(int i = 0; i < 8; i++){
+        for(int j = 0; j < 8; j++){
+            if(before[i][j] == after[i][j]){
+                continue;
+            }
+
+            //When castling both the king and the rook move, the king names the move
+
+            if(before[i][j] * player > 0 && after[i][j] == space && (fromRow < 0 || abs(before[i][j]) == king)){
+                fromRow = i;
+                fromCol = j;
+            }
+            if(after[i][j] * player > 0 && (toRow < 0 || abs(after[i][j]) == king)){
+                toRow = i;
+                toCol = j;
             }
         }
     }
+    if(fromRow < 0 || toRow < 0){
+        return noMove;
+    }
+    int move = (fromRow * 8 + fromCol) | ((toRow * 8 + toCol) << 6);
+    if(abs(before[fromRow][fromCol]) == pawn && abs(after[toRow][toCol]) != pawn){
+        move |= abs(after[toRow][toCol]) << 12;
+    }
+    return move;
+}
 
-    //Removing all illegal moves from list (empty boards)
-    vector<vector<vector<int>>> legalMoveList;
-    legalMoveList.reserve(50);
-    for(vector<vector<int>> legalBoard : moveList){
-        if(!legalBoard.empty()){ // If legal move
-            legalMoveList.push_back(legalBoard);
-        }
+string moveName(int move){
+    if(move == noMove){
+        return "0000";
+    }
+    int from = move & 63, to = (move >> 6) & 63, promotion = move >> 12;
+    string name = squareName(from / 8, from % 8) + squareName(to / 8, to % 8);
+    if(promotion){
+        name += " pnbrq"[promotion];
     }
+    return name;
+}
 
-    return legalMoveList;
-}
\ No newline at end of file
+string moveToString(const vector<vector<int>>& before, const vector<vector<int>>& after){
+    return moveName(encodeMove(before, after));
+}
+
+vector<vector<int>> findMove(const vector<vector<int>>& board, const string& move){
+    for(vector<vector<int>>& newBoard : generateMoves(board)){
+        if(moveToString(board, newBoard) == move){
+            return newBoard;
+        }
+    }
+    return {};
+}
@@ -20,6 +20,8 @@
 #include <cmath>
 #include <algorithm>
 #include <iostream>
+#include <cstdint>
+#include <string>
 
 using namespace std;
 
@@ -28,6 +30,10 @@ using namespace std;
 extern const int blackPlayer;
 extern const int whitePlayer;
 
+//Players as compile time constants, for code specialised to one player
+
+enum Color : int { Black = -1, White = 1 };
+
 extern const int space;
 extern const int pawn; 
 extern const int knight;
@@ -41,8 +47,28 @@ extern const int bothCastlingDisabled;
 extern const int shortCastlingDisabled;
 extern const int longCastlingDisabled;
 
+extern const int noMove;
+
+extern const int gameOngoing;
+extern const int checkmated;
+extern const int stalemated;
+
 extern const vector<vector<int>> startingBoard;
 
+/**
+ * @brief Everything known about which squares each player attacks in a position.
+ * 
+ * Bitboards use bit (row * 8 + column) for board[row][column], arrays are indexed by 1 for
+ * white and 0 for black. Sliding attacks pass through the opposing king, so a king cannot
+ * escape a check by stepping back along the line of the checking piece.
+ */
+struct AttackInfo {
+    uint64_t attacked[2];   // squares each player attacks
+    uint64_t checkers;      // pieces giving check to the player to move
+    uint64_t pinned;        // pieces of the player to move pinned to their king
+    int kingSquare[2];      // square of each king, -1 if it is missing
+};
+
 /**
  * @brief This function returns the position of the king in the game
  * 
@@ -94,4 +120,89 @@ bool isAttacked(const vector<vector<int>> board, pair<int, int> position);
  */
 vector<vector<vector<int>>> generateMoves(const vector<vector<int>> board);
 
+/**
+ * @brief Returns the attack maps, checkers and pinned pieces of a position.
+ * 
+ * They are computed the first time they are asked for and reused until another position is
+ * asked for, so move generation, the stable search and the evaluation of one position share
+ * the work. The cache is per thread.
+ * 
+ * @param board The current board state.
+ * 
+ * @return The attack information of the board (valid until the next call on this thread).
+ */
+const AttackInfo& attackInfo(const vector<vector<int>>& board);
+
+/**
+ * @brief Checks if the current player has at least one legal move.
+ * 
+ * Stops at the first legal move found instead of building every child board.
+ * 
+ * @param board The current board state.
+ * 
+ * @return True if a legal move exists, otherwise false.
+ */
+bool hasLegalMove(const vector<vector<int>> board);
+
+/**
+ * @brief Checks if the king of the current player is under attack.
+ * 
+ * @param board The current board state.
+ * 
+ * @return True if the current player is in check, otherwise false.
+ */
+bool isInCheck(const vector<vector<int>> board);
+
+/**
+ * @brief Classifies the board as an ongoing game, a checkmate or a stalemate.
+ * 
+ * @param board The current board state.
+ * 
+ * @return gameOngoing, checkmated (the current player lost) or stalemated.
+ */
+int gameStatus(const vector<vector<int>> board);
+
+/**
+ * @brief Packs the move between two boards into an int.
+ * 
+ * Bits 0-5 hold the square the piece left and bits 6-11 the square it moved to (row * 8 + column),
+ * bits 12-14 the piece a pawn was promoted to. Castling is encoded as the king's move.
+ * 
+ * @param before The board before the move.
+ * 
+ * @param after The board after the move.
+ * 
+ * @return The packed move, or noMove if the boards are not one move apart.
+ */
+int encodeMove(const vector<vector<int>>& before, const vector<vector<int>>& after);
+
+/**
+ * @brief Names a packed move in coordinate notation, for example e2e4 or e7e8q.
+ */
+string moveName(int move);
+
+/**
+ * @brief Names the move between two boards in coordinate notation, for example e2e4 or e7e8q.
+ * 
+ * Castling is named by the king's move (e1g1).
+ * 
+ * @param before The board before the move.
+ * 
+ * @param after The board after the move.
+ * 
+ * @return The name of the move.
+ */
+string moveToString(const vector<vector<int>>& before, const vector<vector<int>>& after);
+
+/**
+ * @brief Finds the legal move with the given coordinate notation name.
+ * 
+ * @param board The current board state.
+ * 
+ * @param move The move, for example e2e4 or e7e8q.
+ * 
+ * @return The board after the move, or an empty board if no legal move has that name.
+ */
+vector<vector<int>> findMove(const vector<vector<int>>& board, const string& move);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,107 @@
+/**
+ * @file book.hpp
+ * @brief Declaration of the Polyglot opening book.
+ *
+ * A Polyglot book is a file of 16 byte big-endian entries (key, move, weight, learn) sorted by
+ * the Polyglot key of the position. The book is memory-mapped and binary searched, so looking
+ * a position up reads a handful of pages straight from the page cache, which every engine
+ * process on the machine shares.
+ *
+ * Polyglot keys are the XOR of 781 random numbers, like Zobrist keys, and books are keyed with the
+ * numbers published with Polyglot. FrostWeb has 665 of them, the keys are the published ones as
+ * long as the white queen is on the first two ranks, the black queen is not on g6, h6 or a7 to g7
+ * and the black king is on f7 or e8 to h8 (see `hasPublishedKey`), otherwise they are its own. The full list can be loaded with `loadPolyglotKeys` before the first
+ * key is computed. bookTest.cpp checks the keys against Polyglot's published keys.
+ *
+ * @author Anshuman Routray
+ */
+
+#ifndef BOOK_HPP
+#define BOOK_HPP
+
+#include "board.hpp"
+#include "mappedFile.hpp"
+#include <cstdint>
+#include <string>
+
+using namespace std;
+
+/**
+ * @brief One move of a book position.
+ */
+struct BookMove {
+    vector<vector<int>> board;  // the board after the move
+    int move;                   // the move, packed like encodeMove
+    uint16_t weight;            // how often the move should be played, relative to the others
+};
+
+class OpeningBook {
+public:
+
+    /**
+     * @brief Maps a Polyglot book file, closing the book that was open before.
+     *
+     * @return True if the file was mapped and holds whole entries, otherwise false.
+     */
+    bool open(const string& path);
+
+    void close();
+
+    bool isOpen() const { return file.isOpen(); }
+
+    /**
+     * @brief Finds every book move of a position.
+     *
+     * @param board: The chessboard
+     *
+     * @return The legal book moves, empty if the position is not in the book.
+     */
+    vector<BookMove> probe(const vector<vector<int>>& board) const;
+
+    /**
+     * @brief Picks one of the book moves of a position at random, in proportion to their weights.
+     *
+     * @return The board after the move, or an empty board if the position is not in the book.
+     */
+    vector<vector<int>> pickMove(const vector<vector<int>>& board) const;
+
+private:
+    MappedFile file;
+    size_t entryCount = 0;
+};
+
+extern OpeningBook openingBook;
+
+/**
+ * @brief Computes the Polyglot key of a board.
+ */
+uint64_t polyglotKey(const vector<vector<int>>& board);
+
+/**
+ * @brief Tells whether the key of a board only uses published numbers, so other programs compute
+ * the same key. Always true once the numbers were loaded with `loadPolyglotKeys`.
+ */
+bool hasPublishedKey(const vector<vector<int>>& board);
+
+/**
+ * @brief Replaces the 781 random numbers of the Polyglot key, for example with the full published list.
+ *
+ * Only works until the first key is computed, so the numbers never change while a search or
+ * another thread may be reading them. Load them with the options, before anything else runs.
+ *
+ * @param path: A text file with the numbers in Polyglot's order, as hexadecimal (0x...) or decimal
+ *
+ * @return False if the file could not be read, does not hold 781 numbers or keys were already
+ * computed, the numbers are then unchanged.
+ */
+bool loadPolyglotKeys(const string& path);
+
+/**
+ * @brief Converts a move packed like encodeMove to the Polyglot move format.
+ *
+ * @param board: The board the move is played on, to recognise castling (which Polyglot writes as
+ * the king capturing its own rook)
+ */
+uint16_t toPolyglotMove(const vector<vector<int>>& board, int move);
+
+#endif
@@ -0,0 +1,213 @@
+/**
+ * @brief Checks the Polyglot keys against the keys published with the Polyglot book format
+ *
+ * The keys of the positions from the Polyglot documentation are compared with the built-in
+ * numbers, starting with the start position (463b96181691fc9c) and the position after e2e4
+ * (823c9b50fd114196). The later positions check castling rights, en passant and the player to
+ * move. A small book is then written under the published keys and has to give its moves back.
+ * makeBook.exe builds a book from a short PGN, which has to give the games' moves back under the
+ * published keys, without the position whose key needs a number FrostWeb does not have.
+ * Afterwards loading numbers has to fail, because keys are in use.
+ *
+ * Usage: `bookTest.exe [makeBook]`, makeBook defaults to makeBook.exe next to bookTest.exe. The
+ * test files are written to the working directory and removed again.
+ *
+ * It is meant to be compiled like genMove.cpp, with every file that has no main function.
+ *
+ * @author Anshuman Routray
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include "book.hpp"
+#include "notation.hpp"
+
+using namespace std;
+
+struct KeyTest {
+    vector<string> moves;
+    uint64_t key;
+};
+
+const KeyTest KEY_TESTS[] = {
+    {{}, 0x463b96181691fc9cULL},
+    {{"e4"}, 0x823c9b50fd114196ULL},
+    {{"e4", "d5"}, 0x0756b94461c50fb0ULL},
+    {{"e4", "d5", "e5"}, 0x662fafb965db29d4ULL},
+    {{"e4", "d5", "e5", "f5"}, 0x22a48b5a8e47ff78ULL},
+    {{"e4", "d5", "e5", "f5", "Ke2"}, 0x652a607ca3f242c1ULL},
+    {{"e4", "d5", "e5", "f5", "Ke2", "Kf7"}, 0x00fdd303c946bdd9ULL},
+    {{"a4", "b5", "h4", "b4", "c4"}, 0x3c8123ea7b067637ULL},
+    {{"a4", "b5", "h4", "b4", "c4", "bxc3", "Ra3"}, 0x5c3f9b829b279560ULL},
+};
+
+//Entries of the small book, sorted by key: Polyglot moves are the to square, then the from square,
+//three bits for the file and three for the rank each
+
+struct BookEntry {
+    uint64_t key;
+    uint16_t move;
+    uint16_t weight;
+};
+
+const BookEntry BOOK_ENTRIES[] = {
+    {0x0756b94461c50fb0ULL, 0x0724, 1},  // after e4 d5: e4e5
+    {0x463b96181691fc9cULL, 0x031c, 3},  // start: e2e4
+    {0x463b96181691fc9cULL, 0x02db, 1},  // start: d2d4
+    {0x823c9b50fd114196ULL, 0x0ce3, 1},  // after e4: d7d5
+};
+
+//Moves played in two games get into a book made by makeBook.cpp, the white queen on d3 needs a
+//number FrostWeb does not have
+
+const char* PGN_GAMES =
+    "[Result \"1-0\"]\n1. e4 e5 2. Nf3 Nc6 1-0\n\n"
+    "[Result \"0-1\"]\n1. e4 e5 2. Nf3 Nc6 0-1\n\n"
+    "[Result \"1/2-1/2\"]\n1. d4 d5 2. Qd3 Nf6 1/2-1/2\n\n"
+    "[Result \"1/2-1/2\"]\n1. d4 d5 2. Qd3 Nf6 1/2-1/2\n";
+
+const char* BOOK_FILE = "bookTest.bin";
+const char* KEYS_FILE = "bookTest.keys";
+const char* PGN_FILE = "bookTest.pgn";
+const char* MADE_BOOK_FILE = "bookTest.made.bin";
+
+vector<vector<int>> playMoves(const vector<string>& moves){
+    vector<vector<int>> board = startingBoard;
+    for(const string& move : moves){
+        board = findSanMove(board, move);
+        if(board.empty()){
+            break;
+        }
+    }
+    return board;
+}
+
+bool writeBook(const char* path){
+    ofstream output(path, ios::binary);
+    for(const BookEntry& entry : BOOK_ENTRIES){
+        unsigned char bytes[16] = {};
+        for(int i = 0; i < 8; i++){
+            bytes[i] = (unsigned char)(entry.key >> (56 - 8 * i));
+        }
+        bytes[8] = (unsigned char)(entry.move >> 8);
+        bytes[9] = (unsigned char)entry.move;
+        bytes[10] = (unsigned char)(entry.weight >> 8);
+        bytes[11] = (unsigned char)entry.weight;
+        output.write((const char*)bytes, 16);
+    }
+    return (bool)output;
+}
+
+//The coordinate names of the book moves of a position, with their weights
+
+string bookMoves(const OpeningBook& book, const vector<vector<int>>& board){
+    string names;
+    for(const BookMove& move : book.probe(board)){
+        names += (names.empty() ? "" : " ") + moveName(move.move) + ":" + to_string(move.weight);
+    }
+    return names;
+}
+
+int main(int argc, char* argv[]){
+
+    int failures = 0;
+    for(const KeyTest& test : KEY_TESTS){
+        string line = "start";
+        for(const string& move : test.moves){
+            line += " " + move;
+        }
+        vector<vector<int>> board = playMoves(test.moves);
+        uint64_t key = board.empty() ? 0 : polyglotKey(board);
+        bool passed = !board.empty() && key == test.key && hasPublishedKey(board);
+        printf("%-40s %016llx %s\n", line.c_str(), (unsigned long long)key, passed ? "ok" : "FAILED");
+        failures += !passed;
+    }
+
+    //A book keyed with the published keys, as other programs write them
+
+    const pair<vector<string>, string> BOOK_TESTS[] = {
+        {{}, "e2e4:3 d2d4:1"},
+        {{"e4"}, "d7d5:1"},
+        {{"e4", "d5"}, "e4e5:1"},
+        {{"d4"}, ""},
+    };
+    OpeningBook book;
+    if(!writeBook(BOOK_FILE) || !book.open(BOOK_FILE)){
+        cerr << "Could not write " << BOOK_FILE << endl;
+        return 1;
+    }
+    for(const pair<vector<string>, string>& test : BOOK_TESTS){
+        string line = "book start";
+        for(const string& move : test.first){
+            line += " " + move;
+        }
+        string found = bookMoves(book, playMoves(test.first));
+        bool passed = found == test.second;
+        printf("%-40s %-16s %s\n", line.c_str(), found.c_str(), passed ? "ok" : "FAILED");
+        failures += !passed;
+    }
+    book.close();
+    remove(BOOK_FILE);
+
+    //The same round trip through makeBook, which has to write the published keys
+
+    string makeBook = (argc > 1) ? argv[1] : "";
+    if(makeBook.empty()){
+        string self = argv[0];
+        size_t slash = self.find_last_of("/\\");
+        makeBook = ((slash == string::npos) ? "" : self.substr(0, slash + 1)) + "makeBook.exe";
+    }
+    {
+        ofstream pgn(PGN_FILE);
+        pgn << PGN_GAMES;
+    }
+    string command = "\"" + makeBook + "\" " + PGN_FILE + " " + MADE_BOOK_FILE + " 4";
+    fflush(stdout);
+    bool made = system(command.c_str()) == 0 && book.open(MADE_BOOK_FILE);
+    if(!made){
+        printf("%-40s %s\n", ("made with " + makeBook).c_str(), "FAILED");
+        failures++;
+    }
+    const pair<vector<string>, string> MADE_BOOK_TESTS[] = {
+        {{}, "d2d4:2 e2e4:2"},
+        {{"e4"}, "e7e5:2"},
+        {{"e4", "e5"}, "g1f3:2"},
+        {{"e4", "e5", "Nf3"}, "b8c6:2"},
+        {{"d4", "d5"}, "d1d3:2"},
+        {{"d4", "d5", "Qd3"}, ""},
+    };
+    for(const pair<vector<string>, string>& test : MADE_BOOK_TESTS){
+        if(!made){
+            break;
+        }
+        string line = "made book start";
+        for(const string& move : test.first){
+            line += " " + move;
+        }
+        string found = bookMoves(book, playMoves(test.first));
+        bool passed = found == test.second;
+        printf("%-40s %-16s %s\n", line.c_str(), found.c_str(), passed ? "ok" : "FAILED");
+        failures += !passed;
+    }
+    book.close();
+    remove(PGN_FILE);
+    remove(MADE_BOOK_FILE);
+
+    //The keys above are in use now, so the numbers may no longer change
+
+    {
+        ofstream keys(KEYS_FILE);
+        for(int i = 0; i < 781; i++){
+            keys << i + 1 << "\n";
+        }
+    }
+    bool reloaded = loadPolyglotKeys(KEYS_FILE);
+    remove(KEYS_FILE);
+    printf("%-40s %s\n", "reload after use", reloaded ? "FAILED" : "ok");
+    failures += reloaded;
+
+    cout << failures << " failed" << endl;
+    return failures ? 1 : 0;
+}
@@ -21,7 +21,7 @@ void printBoard(vector<vector<int>> board){
         cout << endl;
     }
     cout << board[8][0] << " " << board[8][1] << " " << board[8][2] << " " << board[8][3] 
-        << " " << board[8][4] << " " << board[8][5];
+        << " " << board[8][4] << " " << board[8][5] << " " << board[8][6];
     cout << endl << endl;
 }
 
@@ -35,7 +35,7 @@ int main(){
      {space, space, space, space, space, queen, space, space},
      {pawn, pawn, pawn, pawn, space, pawn, pawn, pawn},
      {rook, knight, bishop, space, rook, space, space, rook},
-     {longCastlingDisabled, bothCastlingEnabled, blackPlayer, 5, 5, 0}};
+     {longCastlingDisabled, bothCastlingEnabled, blackPlayer, 5, 5, 0, 0}};
 
     printBoard(debugboard);
 
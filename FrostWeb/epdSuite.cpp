@@ -0,0 +1,153 @@
+/**
+ * @brief Runs a test suite of EPD positions and reports how many the engine solves
+ *
+ * Every position with a `bm` (best move) or `am` (avoid move) operation is searched once, with
+ * a fixed time or node budget. The position is solved if the engine plays one of the best moves
+ * and none of the moves to avoid. Positions are handed out to a pool of workers, one position
+ * per worker at a time, and every worker searches with its own transposition table, cleared
+ * before each position, so the result of a position does not depend on the ones before it.
+ *
+ * Usage: `epdSuite.exe <file> movetime <ms>` or `epdSuite.exe <file> nodes <count>`, followed by
+ * engine options like `--Threads 8` for the number of workers.
+ *
+ * It is meant to be compiled like genMove.cpp, with every file that has no main function.
+ *
+ * @author Anshuman Routray
+ */
+
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include "notation.hpp"
+#include "options.hpp"
+#include "search.hpp"
+
+using namespace std;
+
+const size_t TABLE_ENTRIES = 1 << 18; //Transposition table entries of each worker
+
+struct SuiteResult {
+    bool solved;
+    string move;
+    double evaluation;
+    int depth;
+    uint64_t nodes;
+};
+
+/**
+ * Finds the moves an operand such as "Qg6 Rxb2+" names, as moves packed like encodeMove.
+ */
+vector<int> operandMoves(const vector<vector<int>>& board, const string& operand){
+    vector<int> moves;
+    istringstream words(operand);
+    string word;
+    while(words >> word){
+        vector<vector<int>> newBoard = findSanMove(board, word);
+        if(!newBoard.empty()){
+            moves.push_back(encodeMove(board, newBoard));
+        }
+    }
+    return moves;
+}
+
+int main(int argc, char* argv[]){
+
+    if(argc < 4 || (string(argv[2]) != "movetime" && string(argv[2]) != "nodes")){
+        cerr << "Usage: " << argv[0] << " <file> movetime <ms> | nodes <count> [--Name value ...]" << endl;
+        return 1;
+    }
+    string limitType = argv[2];
+    uint64_t limit = max(1ULL, strtoull(argv[3], nullptr, 10));
+    parseOptions(argc - 3, argv + 3);
+
+    //Reading the whole suite first, lines that cannot be used are reported and skipped
+
+    ifstream file(argv[1]);
+    if(!file){
+        cerr << "Could not open " << argv[1] << endl;
+        return 1;
+    }
+    vector<EpdRecord> suite;
+    string line;
+    int lineNumber = 0, skipped = 0;
+    while(getline(file, line)){
+        lineNumber++;
+        EpdRecord record;
+        if(line.find_first_not_of(" \t\r") == string::npos){
+            continue;
+        }
+        if(!parseEpd(line, record) || (record.operation("bm").empty() && record.operation("am").empty())){
+            cerr << "WARNING -- SKIPPING LINE " << lineNumber << endl;
+            skipped++;
+            continue;
+        }
+        suite.push_back(record);
+    }
+
+    vector<SuiteResult> results(suite.size());
+    atomic<size_t> nextPosition(0);
+    mutex outputLock;
+
+    auto worker = [&](){
+        TranspositionTable table(TABLE_ENTRIES);
+        size_t index;
+        while((index = nextPosition.fetch_add(1)) < suite.size()){
+            const EpdRecord& record = suite[index];
+            table.clear();
+            SearchLimits limits;
+            limits.useBook = false;
+            limits.table = &table;
+            if(limitType == "nodes"){
+                limits.nodes = limit;
+            }
+            else {
+                limits.deadline = chrono::steady_clock::now() + chrono::milliseconds(limit);
+            }
+            SearchResult search = searchPosition(record.board, limits);
+
+            SuiteResult& result = results[index];
+            result = {false, "none", search.evaluation, search.depth, search.nodes};
+            if(search.bestBoard.size() > 1){
+                int move = encodeMove(record.board, search.bestBoard);
+                vector<int> best = operandMoves(record.board, record.operation("bm"));
+                vector<int> avoid = operandMoves(record.board, record.operation("am"));
+                result.move = moveToSan(record.board, search.bestBoard);
+                result.solved = (record.operation("bm").empty() || find(best.begin(), best.end(), move) != best.end())
+                    && find(avoid.begin(), avoid.end(), move) == avoid.end();
+            }
+
+            string id = record.operation("id");
+            lock_guard<mutex> guard(outputLock);
+            cout << left << setw(12) << (id.empty() ? "#" + to_string(index + 1) : id) << (result.solved ? " solved " : " failed ")
+                << setw(8) << result.move << (record.operation("bm").empty() ? " am " + record.operation("am") : " bm " + record.operation("bm"))
+                << " score " << result.evaluation << " depth " << result.depth << " nodes " << result.nodes << endl;
+        }
+    };
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    vector<thread> workers;
+    for(int i = 0; i < threadCount; i++){
+        workers.emplace_back(worker);
+    }
+    for(thread& thread : workers){
+        thread.join();
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    int solved = 0;
+    uint64_t nodes = 0;
+    for(const SuiteResult& result : results){
+        solved += result.solved;
+        nodes += result.nodes;
+    }
+    cout << fixed << setprecision(1) << "solved " << solved << "/" << suite.size() << " ("
+        << (suite.empty() ? 0.0 : 100.0 * solved / suite.size()) << "%)";
+    if(skipped){
+        cout << ", " << skipped << " lines skipped";
+    }
+    cout << endl << "positions " << suite.size() << " in " << seconds << "s, " << suite.size() / max(seconds, 1e-9)
+        << " positions/s, " << (uint64_t)(nodes / max(seconds, 1e-9)) << " nodes/s, workers " << threadCount << endl;
+    return 0;
+}
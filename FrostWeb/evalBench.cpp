@@ -0,0 +1,82 @@
+/**
+ * @brief Checks and times the batch evaluation against the plain evaluation function
+ *
+ * Plays random games from the starting position to collect positions, packs them, then checks
+ * that evaluateBatch gives every position the same score as evaluate (in centipawns) and times
+ * both. The plain evaluation is timed on boards that are already built, the batch on packed
+ * positions, since that is how each of them is used.
+ *
+ * It is meant to be compiled like genMove.cpp, with every file that has no main function.
+ * Add -DFROSTWEB_NO_SIMD to time the batch evaluation without AVX2.
+ *
+ * @author Anshuman Routray
+ */
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include "evaluate.hpp"
+#include "notation.hpp"
+
+using namespace std;
+
+const int POSITIONS = 200000; //Positions to collect
+const int ROUNDS = 5; //Times each evaluation goes through all of them
+
+int main(){
+
+    //Random games, restarted when they end or get long
+
+    mt19937_64 generator(2024);
+    vector<vector<vector<int>>> boards;
+    vector<PackedBoard> packed;
+    vector<vector<int>> board = startingBoard;
+    int ply = 0;
+    while((int)boards.size() < POSITIONS){
+        vector<vector<vector<int>>> moveList = generateMoves(board);
+        if(moveList.empty() || ply++ > 150){
+            board = startingBoard;
+            ply = 0;
+            continue;
+        }
+        board = moveList[generator() % moveList.size()];
+        PackedBoard position;
+        if(packBoard(board, position)){
+            boards.push_back(board);
+            packed.push_back(position);
+        }
+    }
+
+    vector<int> batch(packed.size());
+    evaluateBatch(packed.data(), packed.size(), batch.data());
+    int mismatches = 0;
+    for(size_t i = 0; i < boards.size(); i++){
+        if(batch[i] != (int)lround(100 * evaluate(boards[i]))){
+            mismatches++;
+        }
+    }
+    cout << "positions " << boards.size() << ", mismatches " << mismatches << endl;
+
+    double checksum = 0;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for(int round = 0; round < ROUNDS; round++){
+        for(const vector<vector<int>>& position : boards){
+            checksum += evaluate(position);
+        }
+    }
+    double scalarSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    start = chrono::steady_clock::now();
+    for(int round = 0; round < ROUNDS; round++){
+        evaluateBatch(packed.data(), packed.size(), batch.data());
+        checksum += batch[round];
+    }
+    double batchSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    double evaluations = (double)ROUNDS * boards.size();
+    cout << "evaluate      " << evaluations / scalarSeconds / 1e6 << "M positions/s" << endl;
+    cout << "evaluateBatch " << evaluations / batchSeconds / 1e6 << "M positions/s" << endl;
+    cout << "speedup " << scalarSeconds / batchSeconds << "x (checksum " << checksum << ")" << endl;
+    return mismatches != 0;
+}
@@ -3,7 +3,8 @@
  * @brief This file contains the evaluation function for a chess engine.
  * 
  * The evaluation function calculates the score of a given chessboard state based on
- * material and positional values of the pieces. Positive values indicate an advantage
+ * material and positional values of the pieces, the pawn structure and the safety of the kings.
+ * Positive values indicate an advantage
  * for White, while negative values favor Black.
  * 
  * @author Anshuman Routray
@@ -11,6 +12,20 @@
  */
 
 #include "evaluate.hpp"
+#include "board.hpp"
+#include "attacks.hpp"
+#include "zobrist.hpp"
+#include "notation.hpp"
+#include <atomic>
+#include <cmath>
+#include <cstring>
+
+//Building with -DFROSTWEB_NO_SIMD leaves out the AVX2 code, to compare it with the plain loop
+
+#if !defined(FROSTWEB_NO_SIMD) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define FROSTWEB_AVX2 1
+#endif
 
 using namespace std;
 
@@ -18,6 +33,135 @@ using namespace std;
 
 const vector<int> pieceValues = {0, 1, 3, 3, 5, 9, 100};
 
+//Penalty for every square around a king (and the king's own square) that the opponent attacks
+
+const double kingZonePenalty = 0.05;
+
+//Pawn structure terms, passed pawns are indexed by their distance from their own back row
+
+const double doubledPawnPenalty = 0.1;
+const double isolatedPawnPenalty = 0.15;
+const double backwardPawnPenalty = 0.08;
+const double passedPawnBonus[8] = {0.0, 0.1, 0.1, 0.15, 0.25, 0.4, 0.6, 0.0};
+const double freePassedPawnBonus = 0.1;
+
+//The pawn structure rarely changes between neighbouring positions, so its score is cached per thread.
+//One entry holds the pawns of both colours. Terms that also depend on other pieces (the free passed
+//pawn bonus, king safety) are added after the lookup, so they never split a structure into more entries
+
+struct PawnEntry {
+    uint64_t key;
+    double score;
+    uint64_t passed[2];
+};
+
+//Entries per thread, 32 bytes each. An empty entry is the entry of a board without pawns, which
+//scores nothing, so it needs no flag to tell it apart
+
+const size_t pawnTableEntries = 1 << 16;
+
+static thread_local vector<PawnEntry> pawnTable;
+static thread_local CacheStats pawnStats = {0, 0};
+
+static uint64_t fileMask(int column){
+    return 0x0101010101010101ULL << column;
+}
+
+//Every row strictly ahead of a row, from the point of view of a player (white pawns move towards row 0)
+
+static uint64_t rowsAhead(int row, int side){
+    return (side == 1) ? ((1ULL << (row * 8)) - 1) : ((row == 7) ? 0 : (~0ULL << ((row + 1) * 8)));
+}
+
+static uint64_t adjacentFiles(int column){
+    return ((column > 0) ? fileMask(column - 1) : 0) | ((column < 7) ? fileMask(column + 1) : 0);
+}
+
+/**
+ * @brief Scores the doubled, isolated, backward and passed pawns of a board from white's point of view.
+ * 
+ * @param pawns The pawns of black (index 0) and white (index 1).
+ * 
+ * @return The cached entry for the pawn structure.
+ */
+static PawnEntry evaluatePawns(const uint64_t pawns[2]){
+    PawnEntry entry = {0, 0.0, {0, 0}};
+    for(int side = 0; side < 2; side++){
+        double score = 0;
+        uint64_t enemyAttacks = 0;
+        uint64_t enemyPawns = pawns[!side];
+        while(enemyPawns){
+            enemyAttacks |= pawnAttacks(side ? -1 : 1, popSquare(enemyPawns));
+        }
+        uint64_t ownPawns = pawns[side];
+        while(ownPawns){
+            int square = popSquare(ownPawns);
+            int row = square / 8, column = square % 8;
+            uint64_t ahead = rowsAhead(row, side);
+            uint64_t behind = ~ahead & ~(0xFFULL << (row * 8));
+            if(pawns[side] & fileMask(column) & ahead){
+                score -= doubledPawnPenalty;
+            }
+            if(!(pawns[side] & adjacentFiles(column))){
+                score -= isolatedPawnPenalty;
+            }
+            else if(!(pawns[side] & adjacentFiles(column) & (behind | (0xFFULL << (row * 8)))) &&
+                (enemyAttacks & (1ULL << (square + ((side == 1) ? -8 : 8))))){
+
+                //Every neighbouring pawn is further advanced and the square in front is guarded by an enemy pawn
+
+                score -= backwardPawnPenalty;
+            }
+            if(!(pawns[!side] & (fileMask(column) | adjacentFiles(column)) & ahead)){
+                entry.passed[side] |= 1ULL << square;
+                score += passedPawnBonus[(side == 1) ? 7 - row : row];
+            }
+        }
+        entry.score += (side == 1) ? score : -score;
+    }
+    return entry;
+}
+
+CacheStats pawnTableStats(){
+    return pawnStats;
+}
+
+//Evaluation cache shared by every thread, the zeroed static array costs nothing until it is used
+
+struct EvalEntry {
+    atomic<uint64_t> check;  // key XOR evaluation bits
+    atomic<uint64_t> evaluation;
+};
+
+const size_t evalCacheSize = 1 << 18;
+
+static EvalEntry evalCache[evalCacheSize];
+static atomic<uint64_t> evalCacheProbes(0);
+static atomic<uint64_t> evalCacheHits(0);
+
+double cachedEvaluate(const vector<vector<int>>& board){
+    uint64_t key = zobristKey(board);
+    EvalEntry& entry = evalCache[key & (evalCacheSize - 1)];
+    uint64_t check = entry.check.load(memory_order_relaxed);
+    uint64_t bits = entry.evaluation.load(memory_order_relaxed);
+    evalCacheProbes.fetch_add(1, memory_order_relaxed);
+    double evaluation;
+    if((check ^ bits) == key){
+        evalCacheHits.fetch_add(1, memory_order_relaxed);
+        memcpy(&evaluation, &bits, sizeof(bits));
+        return evaluation;
+    }
+    evaluation = evaluate(board);
+    memcpy(&bits, &evaluation, sizeof(bits));
+    entry.check.store(key ^ bits, memory_order_relaxed);
+    entry.evaluation.store(bits, memory_order_relaxed);
+    return evaluation;
+}
+
+CacheStats evalCacheStats(){
+    return {evalCacheProbes.load(memory_order_relaxed), evalCacheHits.load(memory_order_relaxed)};
+}
+
 double piecePos[7][8][8] = {
     // Pawn positions
     {{0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0},
@@ -105,5 +249,257 @@ double evaluate(vector<vector<int>> board){
             evaluation += (piece > 0) ? (piecePos[abs(piece)][row][column]) : (-piecePos[abs(piece)][row][column]);
         } 
     }
+
+    //Pawn structure, looked up in the pawn table before it is computed
+
+    uint64_t key = pawnKey(board);
+    if(pawnTable.empty()){
+        pawnTable.assign(pawnTableEntries, PawnEntry{0, 0.0, {0, 0}});
+    }
+    PawnEntry& pawnEntry = pawnTable[key & (pawnTableEntries - 1)];
+    pawnStats.probes++;
+    if(pawnEntry.key == key){
+        pawnStats.hits++;
+    }
+    else {
+        uint64_t pawns[2] = {0, 0};
+        for(int square = 8; square < 56; square++){
+            int piece = board[square / 8][square % 8];
+            if(abs(piece) == pawn){
+                pawns[piece > 0] |= 1ULL << square;
+            }
+        }
+        pawnEntry = evaluatePawns(pawns);
+        pawnEntry.key = key;
+    }
+    evaluation += pawnEntry.score;
+
+    //Passed pawns with nothing standing right in front of them are worth a little more
+
+    for(int side = 0; side < 2; side++){
+        uint64_t passed = pawnEntry.passed[side];
+        while(passed){
+            int square = popSquare(passed) + ((side == 1) ? -8 : 8);
+            if(board[square / 8][square % 8] == space){
+                evaluation += (side == 1) ? freePassedPawnBonus : -freePassedPawnBonus;
+            }
+        }
+    }
+
+    //King safety, read from the attack maps the search already computed for this position
+
+    const AttackInfo& info = attackInfo(board);
+    for(int side = 0; side < 2; side++){
+        if(info.kingSquare[side] < 0){
+            continue;
+        }
+        uint64_t kingZone = kingAttacks(info.kingSquare[side]) | (1ULL << info.kingSquare[side]);
+        uint64_t attackedZone = kingZone & info.attacked[!side];
+        int attackedSquares = 0;
+        while(attackedZone){
+            popSquare(attackedZone);
+            attackedSquares++;
+        }
+        evaluation += ((side == 1) ? -kingZonePenalty : kingZonePenalty) * attackedSquares;
+    }
     return evaluation;
-}
\ No newline at end of file
+}
+
+//Batch evaluation works in whole centipawns straight from packed positions, without building boards
+
+static int toCentipawns(double value){
+    return (int)lround(value * 100);
+}
+
+/**
+ * Fills the material plus piece-square value of every packed piece code on every square, in centipawns
+ * from white's point of view. Empty squares and unused codes are worth nothing.
+ */
+static void buildPieceSquareTable(int table[16][64]){
+    for(int code = 0; code < 16; code++){
+        int piece = (code >= 1 && code <= 6) ? code : ((code >= 9 && code <= 14) ? 8 - code : 0);
+        for(int square = 0; square < 64; square++){
+            int value = toCentipawns(pieceValues[abs(piece)]) + toCentipawns(piecePos[abs(piece)][square / 8][square % 8]);
+            table[code][square] = (piece >= 0) ? value : -value;
+        }
+    }
+}
+
+/**
+ * Calls visit(square, code) for every piece of a packed position, in square order.
+ */
+template<typename Visitor>
+static void visitPackedPieces(const PackedBoard& packed, Visitor visit){
+    uint64_t occupancy = packed.occupancy;
+    for(int count = 0; occupancy; count++){
+        int square = popSquare(occupancy);
+        visit(square, (count % 2) ? (packed.pieces[count / 2] >> 4) : (packed.pieces[count / 2] & 15));
+    }
+}
+
+static int pieceSquareSum(const int table[16][64], const PackedBoard& packed){
+    int sum = 0;
+    visitPackedPieces(packed, [&](int square, int code){
+        sum += table[code][square];
+    });
+    return sum;
+}
+
+#ifdef FROSTWEB_AVX2
+
+/**
+ * Sums the piece-square values of one position with AVX2: the nibbles are split into 32 piece codes
+ * with a few vector instructions, then the values of 8 pieces at a time are fetched with one gather.
+ * Codes past the last piece are 0, an empty square, whose values are all 0.
+ */
+__attribute__((target("avx2")))
+static int pieceSquareSumAvx2(const int table[16][64], const PackedBoard& packed){
+    alignas(32) uint8_t codes[32];
+    alignas(32) uint8_t squares[32] = {};
+    __m128i nibbles = _mm_loadu_si128((const __m128i*)packed.pieces);
+    __m128i low = _mm_and_si128(nibbles, _mm_set1_epi8(15));
+    __m128i high = _mm_and_si128(_mm_srli_epi16(nibbles, 4), _mm_set1_epi8(15));
+    _mm_store_si128((__m128i*)codes, _mm_unpacklo_epi8(low, high));
+    _mm_store_si128((__m128i*)(codes + 16), _mm_unpackhi_epi8(low, high));
+    uint64_t occupancy = packed.occupancy;
+    for(int count = 0; occupancy; count++){
+        squares[count] = (uint8_t)popSquare(occupancy);
+    }
+    __m256i total = _mm256_setzero_si256();
+    for(int group = 0; group < 32; group += 8){
+        __m256i pieceCodes = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(codes + group)));
+        __m256i pieceSquares = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(squares + group)));
+        __m256i index = _mm256_add_epi32(_mm256_slli_epi32(pieceCodes, 6), pieceSquares);
+        total = _mm256_add_epi32(total, _mm256_i32gather_epi32(&table[0][0], index, 4));
+    }
+    __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(total), _mm256_extracti128_si256(total, 1));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(sum);
+}
+
+#endif
+
+/**
+ * Finds the squares of a king zone the other player attacks, like the attack maps of attackInfo
+ * (sliders see through the king) but only looking at the few squares of the zone.
+ */
+static uint64_t kingZoneAttacks(const int squares[64], uint64_t occupied, uint64_t attackers, uint64_t kingZone, int kingSquare){
+    uint64_t blockers = occupied & ~(1ULL << kingSquare);
+    uint64_t attacked = 0;
+    for(uint64_t pieces = attackers; pieces; ){
+        int square = popSquare(pieces);
+        int piece = squares[square];
+        int pieceType = abs(piece);
+        if(pieceType == pawn){
+            attacked |= pawnAttacks(piece, square) & kingZone;
+        }
+        else if(pieceType == knight){
+            attacked |= knightAttacks(square) & kingZone;
+        }
+        else if(pieceType == king){
+            attacked |= kingAttacks(square) & kingZone;
+        }
+        else {
+
+            //A slider reaches the 3x3 zone only along a row, column or diagonal passing within one square of the king
+
+            int rowDistance = abs(square / 8 - kingSquare / 8), columnDistance = abs(square % 8 - kingSquare % 8);
+            bool nearLine = (pieceType != bishop && (rowDistance <= 1 || columnDistance <= 1))
+                || (pieceType != rook && abs(rowDistance - columnDistance) <= 2);
+            if(!nearLine){
+                continue;
+            }
+            for(uint64_t targets = kingZone & ~attacked; targets; ){
+                int target = popSquare(targets);
+                bool straight = square / 8 == target / 8 || square % 8 == target % 8;
+                if(target != square && lineSquares(square, target) && (straight ? pieceType != bishop : pieceType != rook)
+                    && !(betweenSquares(square, target) & blockers)){
+                    attacked |= 1ULL << target;
+                }
+            }
+        }
+    }
+    return attacked;
+}
+
+//Positions of one game share their pawn structures, the batch keeps its own table of them keyed by
+//the pawns themselves (the board's pawn key needs a board)
+
+struct BatchPawnEntry {
+    uint64_t pawns[2];
+    PawnEntry entry;
+};
+
+static thread_local vector<BatchPawnEntry> batchPawnTable;
+
+static const PawnEntry& batchPawnEntry(const uint64_t pawns[2]){
+    if(batchPawnTable.empty()){
+        batchPawnTable.assign(pawnTableEntries, BatchPawnEntry{{0, 0}, PawnEntry{0, 0.0, {0, 0}}});
+    }
+    uint64_t hash = (pawns[0] * 0x9E3779B97F4A7C15ULL) ^ (pawns[1] * 0xC2B2AE3D27D4EB4FULL);
+    BatchPawnEntry& slot = batchPawnTable[(hash >> 32) & (pawnTableEntries - 1)];
+    if(slot.pawns[0] != pawns[0] || slot.pawns[1] != pawns[1]){
+        slot.pawns[0] = pawns[0];
+        slot.pawns[1] = pawns[1];
+        slot.entry = evaluatePawns(pawns);
+    }
+    return slot.entry;
+}
+
+/**
+ * Scores everything but the piece-square values: the pawn structure and the safety of the kings,
+ * computed like evaluate does.
+ */
+static int structureSum(const PackedBoard& packed){
+    int squares[64] = {};
+    int kingSquares[2] = {-1, -1};
+    uint64_t pawns[2] = {0, 0}, pieces[2] = {0, 0};
+    visitPackedPieces(packed, [&](int square, int code){
+        squares[square] = (code < 8) ? code : 8 - code;
+        pieces[code < 8] |= 1ULL << square;
+        if(abs(squares[square]) == king){
+            kingSquares[squares[square] > 0] = square;
+        }
+        if(abs(squares[square]) == pawn && square >= 8 && square < 56){
+            pawns[squares[square] > 0] |= 1ULL << square;
+        }
+    });
+    PawnEntry pawnEntry = batchPawnEntry(pawns);
+    int sum = toCentipawns(pawnEntry.score);
+    for(int side = 0; side < 2; side++){
+        uint64_t passed = pawnEntry.passed[side];
+        while(passed){
+            int square = popSquare(passed) + ((side == 1) ? -8 : 8);
+            if(squares[square] == space){
+                sum += (side == 1) ? toCentipawns(freePassedPawnBonus) : -toCentipawns(freePassedPawnBonus);
+            }
+        }
+    }
+    for(int side = 0; side < 2; side++){
+        int kingSquare = kingSquares[side];
+        if(kingSquare < 0){
+            continue;
+        }
+        uint64_t kingZone = kingAttacks(kingSquare) | (1ULL << kingSquare);
+        uint64_t attackedZone = kingZoneAttacks(squares, packed.occupancy, pieces[!side], kingZone, kingSquare);
+        sum += ((side == 1) ? -toCentipawns(kingZonePenalty) : toCentipawns(kingZonePenalty)) * bitCount(attackedZone);
+    }
+    return sum;
+}
+
+void evaluateBatch(const PackedBoard* positions, size_t count, int* centipawns){
+    int table[16][64];
+    buildPieceSquareTable(table);
+#ifdef FROSTWEB_AVX2
+    if(__builtin_cpu_supports("avx2")){
+        for(size_t i = 0; i < count; i++){
+            centipawns[i] = pieceSquareSumAvx2(table, positions[i]) + structureSum(positions[i]);
+        }
+        return;
+    }
+#endif
+    for(size_t i = 0; i < count; i++){
+        centipawns[i] = pieceSquareSum(table, positions[i]) + structureSum(positions[i]);
+    }
+}
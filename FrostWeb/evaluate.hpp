@@ -14,11 +14,30 @@
 
 #include <vector>
 #include <cstdlib>
+#include <cstdint>
 
 using namespace std;
 
+struct PackedBoard;
+
 extern const vector<int> pieceValues;
 
+//Positional value of every piece on every square, the same table for both colors (tune.cpp regenerates it)
+
+extern double piecePos[7][8][8];
+
+//Number of lookups into a cache and how many of them found what they were looking for
+
+struct CacheStats {
+    uint64_t probes;
+    uint64_t hits;
+};
+
+/**
+ * @brief Returns the lookups into the pawn structure table of the calling thread.
+ */
+CacheStats pawnTableStats();
+
 /**
  * @brief An evaluation function for a chessboard
  * 
@@ -31,4 +50,40 @@ extern const vector<int> pieceValues;
  */
 double evaluate(vector<vector<int>> board);
 
+/**
+ * @brief Returns the evaluation of a board, looking it up in the evaluation cache first.
+ * 
+ * The cache is a fixed-size table shared by every thread, keyed by the Zobrist key of the board.
+ * It is lockless: each entry stores its key XORed with its evaluation, so an entry torn by two
+ * threads writing at once simply misses.
+ * 
+ * @param board: This is the chessboard
+ * 
+ * @return The same value evaluate(board) returns.
+ */
+double cachedEvaluate(const vector<vector<int>>& board);
+
+/**
+ * @brief Returns the lookups into the evaluation cache of every thread since the engine started.
+ */
+CacheStats evalCacheStats();
+
+/**
+ * @brief Evaluates many packed positions at once, in centipawns.
+ * 
+ * The evaluation terms are whole centipawns, so they are summed as integers: every result equals
+ * lround(100 * evaluate(board)) of the unpacked board. With AVX2 (checked when called) the
+ * piece-square values of eight pieces are fetched at a time, otherwise one by one. The tables
+ * are read on every call, so changes to them (by a tuner) are picked up.
+ * 
+ * evalBench.cpp checks the results against evaluate and times both.
+ * 
+ * @param positions: The positions, packed by `packBoard`
+ * 
+ * @param count: The number of positions
+ * 
+ * @param centipawns: Receives one evaluation per position
+ */
+void evaluateBatch(const PackedBoard* positions, size_t count, int* centipawns);
+
 #endif
\ No newline at end of file
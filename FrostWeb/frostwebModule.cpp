@@ -0,0 +1,440 @@
+/**
+ * @file frostwebModule.cpp
+ * @brief Python extension module running the FrostWeb engine inside the Python process.
+ *
+ * The module `frostweb` has one type, `Position`, which holds a board and its game history:
+ *
+ *     import frostweb
+ *     position = frostweb.Position()              # or Position(board) with FrostWeb.py's 9 row board
+ *     position.legal_moves(6, 4)                  # [(5, 4), (4, 4)], squares e2 can move to
+ *     position.play_move("e2e4")                  # or position.play(6, 4, 4, 4)
+ *     position.fen()                              # set_fen(fen) sets one up, pack() / unpack(data) use 32 bytes
+ *     position.status()                           # 100 ongoing, -1 checkmated, 0 stalemated
+ *     position.search(depth=6, movetime=2000)     # returns at once, the search runs on its own thread
+ *     position.best_move()                        # ("e7e5", -0.1, 4) so far, or None
+ *     position.wait()                             # the final ("e7e5", score, depth), None if the game is over
+ *
+ * `search` also takes `nodes`, `skill`, `ponder` and a `callback`, which is called with the final result
+ * on the search thread (possibly just after `wait()` has returned). `stop()` ends a search early and `ponderhit()` turns a ponder search into a
+ * normal one. The board cannot be changed while a search is running.
+ *
+ * It is compiled as a shared library with every engine file but the ones with a main function, for example
+ * `g++ -std=c++17 -O2 -shared -fPIC $(python3-config --includes) board.cpp book.cpp evaluate.cpp mappedFile.cpp
+ * notation.cpp options.cpp search.cpp server.cpp tablebase.cpp transposition.cpp zobrist.cpp frostwebModule.cpp
+ * -o frostweb$(python3-config --extension-suffix) -pthread`
+ *
+ * @author Anshuman Routray
+ */
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include "notation.hpp"
+#include "search.hpp"
+#include "zobrist.hpp"
+
+using namespace std;
+
+//Everything a Position owns on the C++ side
+
+struct Game {
+    vector<vector<int>> board = startingBoard;
+    vector<uint64_t> history;
+    vector<vector<int>> searchBoard;        // the board the running search started from
+    shared_ptr<SearchHandle> search;
+    shared_ptr<atomic<bool>> ponder;
+};
+
+struct PositionObject {
+    PyObject_HEAD
+    Game* game;
+};
+
+/**
+ * Converts a search result to the (move, score, depth) tuple handed to Python.
+ */
+static PyObject* resultToPython(const vector<vector<int>>& board, const SearchResult& result){
+    if(result.bestBoard.empty()){
+        Py_RETURN_NONE;
+    }
+    if(result.bestBoard.size() == 1){
+        return Py_BuildValue("(Odi)", Py_None, result.evaluation, result.depth);
+    }
+    return Py_BuildValue("(sdi)", moveToString(board, result.bestBoard).c_str(), result.evaluation, result.depth);
+}
+
+static bool isSearching(Game* game){
+    if(game->search && !game->search->isFinished()){
+        PyErr_SetString(PyExc_RuntimeError, "a search is running on this position");
+        return true;
+    }
+    return false;
+}
+
+//Waiting for a search thread, which may itself be waiting to run a Python callback, needs the GIL released
+
+static void releaseSearch(Game* game){
+    shared_ptr<SearchHandle> search = move(game->search);
+    if(search){
+        search->stop();
+        Py_BEGIN_ALLOW_THREADS
+        search.reset();
+        Py_END_ALLOW_THREADS
+    }
+}
+
+static bool boardFromPython(PyObject* object, vector<vector<int>>& board){
+    PyObject* rows = PySequence_Fast(object, "the board must be a list of rows");
+    if(!rows){
+        return false;
+    }
+    bool valid = PySequence_Fast_GET_SIZE(rows) == 9;
+    board.assign(9, vector<int>(8, 0));
+    board[8].assign(7, 0);
+    for(Py_ssize_t i = 0; valid && i < 9; i++){
+        PyObject* row = PySequence_Fast(PySequence_Fast_GET_ITEM(rows, i), "every row must be a list");
+        if(!row){
+            Py_DECREF(rows);
+            return false;
+        }
+        Py_ssize_t size = PySequence_Fast_GET_SIZE(row);
+
+        //Like genMove, the half move clock may be left out of the metadata row
+
+        valid = (i < 8) ? (size == 8) : (size == 6 || size == 7);
+        for(Py_ssize_t j = 0; valid && j < size; j++){
+            board[i][j] = (int)PyLong_AsLong(PySequence_Fast_GET_ITEM(row, j));
+            valid = !PyErr_Occurred();
+        }
+        Py_DECREF(row);
+    }
+    Py_DECREF(rows);
+    if(!valid && !PyErr_Occurred()){
+        PyErr_SetString(PyExc_ValueError, "the board needs 8 rows of 8 squares and a metadata row");
+    }
+    return valid;
+}
+
+static int Position_init(PositionObject* self, PyObject* args, PyObject* kwargs){
+    static const char* keywords[] = {"board", nullptr};
+    PyObject* board = nullptr;
+    if(!PyArg_ParseTupleAndKeywords(args, kwargs, "|O", const_cast<char**>(keywords), &board)){
+        return -1;
+    }
+    releaseSearch(self->game);
+    vector<vector<int>> newBoard = startingBoard;
+    if(board && board != Py_None && !boardFromPython(board, newBoard)){
+        return -1;
+    }
+    self->game->board = newBoard;
+    self->game->history.clear();
+    return 0;
+}
+
+static PyObject* Position_new(PyTypeObject* type, PyObject*, PyObject*){
+    PositionObject* self = (PositionObject*)type->tp_alloc(type, 0);
+    if(self){
+        self->game = new Game();
+    }
+    return (PyObject*)self;
+}
+
+static void Position_dealloc(PositionObject* self){
+    PyTypeObject* type = Py_TYPE(self);
+    releaseSearch(self->game);
+    delete self->game;
+    type->tp_free((PyObject*)self);
+    Py_DECREF(type);
+}
+
+static PyObject* Position_board(PositionObject* self, PyObject*){
+    const vector<vector<int>>& board = self->game->board;
+    PyObject* rows = PyList_New(board.size());
+    for(size_t i = 0; i < board.size(); i++){
+        PyObject* row = PyList_New(board[i].size());
+        for(size_t j = 0; j < board[i].size(); j++){
+            PyList_SET_ITEM(row, j, PyLong_FromLong(board[i][j]));
+        }
+        PyList_SET_ITEM(rows, i, row);
+    }
+    return rows;
+}
+
+/**
+ * Replaces the board of a position, which starts a new game history.
+ */
+static PyObject* setBoard(PositionObject* self, const vector<vector<int>>& board){
+    Game* game = self->game;
+    if(isSearching(game)){
+        return nullptr;
+    }
+    releaseSearch(game);
+    game->board = board;
+    game->history.clear();
+    Py_RETURN_NONE;
+}
+
+static PyObject* Position_fen(PositionObject* self, PyObject*){
+    return PyUnicode_FromString(boardToFen(self->game->board).c_str());
+}
+
+static PyObject* Position_set_fen(PositionObject* self, PyObject* args){
+    const char* fen;
+    if(!PyArg_ParseTuple(args, "s", &fen)){
+        return nullptr;
+    }
+    vector<vector<int>> board = boardFromFen(fen);
+    if(board.empty()){
+        PyErr_SetString(PyExc_ValueError, "invalid FEN");
+        return nullptr;
+    }
+    return setBoard(self, board);
+}
+
+static PyObject* Position_pack(PositionObject* self, PyObject*){
+    PackedBoard packed;
+    if(!packBoard(self->game->board, packed)){
+        PyErr_SetString(PyExc_ValueError, "too many pieces to pack");
+        return nullptr;
+    }
+    return PyBytes_FromStringAndSize((const char*)&packed, sizeof(packed));
+}
+
+static PyObject* Position_unpack(PositionObject* self, PyObject* args){
+    Py_buffer data;
+    if(!PyArg_ParseTuple(args, "y*", &data)){
+        return nullptr;
+    }
+    PackedBoard packed;
+    bool valid = data.len == (Py_ssize_t)sizeof(packed);
+    if(valid){
+        memcpy(&packed, data.buf, sizeof(packed));
+    }
+    PyBuffer_Release(&data);
+    if(!valid){
+        PyErr_SetString(PyExc_ValueError, "a packed position is 32 bytes");
+        return nullptr;
+    }
+    return setBoard(self, unpackBoard(packed));
+}
+
+static PyObject* Position_legal_moves(PositionObject* self, PyObject* args){
+    int row, column;
+    if(!PyArg_ParseTuple(args, "ii", &row, &column)){
+        return nullptr;
+    }
+    PyObject* targets = PyList_New(0);
+    if(row < 0 || row > 7 || column < 0 || column > 7){
+        return targets;
+    }
+
+    //Promotions to different pieces land on the same square, it is listed once
+
+    int from = row * 8 + column, lastTarget = -1;
+    for(const vector<vector<int>>& newBoard : generateMoves(self->game->board)){
+        int move = encodeMove(self->game->board, newBoard);
+        int to = (move >> 6) & 63;
+        if((move & 63) == from && to != lastTarget){
+            PyObject* target = Py_BuildValue("(ii)", to / 8, to % 8);
+            PyList_Append(targets, target);
+            Py_DECREF(target);
+            lastTarget = to;
+        }
+    }
+    return targets;
+}
+
+static PyObject* playNamedMove(PositionObject* self, const string& name){
+    Game* game = self->game;
+    if(isSearching(game)){
+        return nullptr;
+    }
+    vector<vector<int>> newBoard = findMove(game->board, name);
+    if(newBoard.empty()){
+        Py_RETURN_FALSE;
+    }
+    game->history.push_back(zobristKey(game->board));
+    game->board = newBoard;
+    Py_RETURN_TRUE;
+}
+
+static PyObject* Position_play_move(PositionObject* self, PyObject* args){
+    const char* name;
+    if(!PyArg_ParseTuple(args, "s", &name)){
+        return nullptr;
+    }
+    return playNamedMove(self, name);
+}
+
+static PyObject* Position_play(PositionObject* self, PyObject* args){
+    int fromRow, fromColumn, toRow, toColumn, promotion = queen;
+    if(!PyArg_ParseTuple(args, "iiii|i", &fromRow, &fromColumn, &toRow, &toColumn, &promotion)){
+        return nullptr;
+    }
+    if(fromRow < 0 || fromRow > 7 || toRow < 0 || toRow > 7 || fromColumn < 0 || fromColumn > 7 || toColumn < 0 || toColumn > 7){
+        Py_RETURN_FALSE;
+    }
+    int move = (fromRow * 8 + fromColumn) | ((toRow * 8 + toColumn) << 6);
+    const vector<vector<int>>& board = self->game->board;
+    if(abs(board[fromRow][fromColumn]) == pawn && (toRow == 0 || toRow == 7)){
+        move |= abs(promotion) << 12;
+    }
+    return playNamedMove(self, moveName(move));
+}
+
+static PyObject* Position_status(PositionObject* self, PyObject*){
+    return PyLong_FromLong(gameStatus(self->game->board));
+}
+
+static PyObject* Position_in_check(PositionObject* self, PyObject*){
+    return PyBool_FromLong(isInCheck(self->game->board));
+}
+
+static PyObject* Position_search(PositionObject* self, PyObject* args, PyObject* kwargs){
+    static const char* keywords[] = {"depth", "movetime", "nodes", "skill", "ponder", "callback", nullptr};
+    int depth = maxPly, movetime = 0, ponder = 0;
+    unsigned long long nodes = 0;
+    const char* skill = nullptr;
+    PyObject* callback = Py_None;
+    if(!PyArg_ParseTupleAndKeywords(args, kwargs, "|iiKzpO", const_cast<char**>(keywords),
+        &depth, &movetime, &nodes, &skill, &ponder, &callback)){
+        return nullptr;
+    }
+    Game* game = self->game;
+    if(isSearching(game)){
+        return nullptr;
+    }
+    if(callback != Py_None && !PyCallable_Check(callback)){
+        PyErr_SetString(PyExc_TypeError, "callback must be callable");
+        return nullptr;
+    }
+    SearchLimits limits;
+    limits.depth = max(1, min(depth, maxPly));
+    if(movetime > 0){
+        limits.deadline = chrono::steady_clock::now() + chrono::milliseconds(movetime);
+    }
+    if(nodes > 0){
+        limits.nodes = nodes;
+    }
+    if(skill && !applySkillLevel(skill, limits)){
+        PyErr_Format(PyExc_ValueError, "unknown skill level %s", skill);
+        return nullptr;
+    }
+    releaseSearch(game);
+    game->ponder = ponder ? make_shared<atomic<bool>>(true) : nullptr;
+    limits.ponder = game->ponder.get();
+    game->searchBoard = game->board;
+
+    //The callback runs on the search thread, which has to take the GIL first
+
+    function<void(const SearchResult&)> onFinished;
+    if(callback != Py_None){
+        Py_INCREF(callback);
+        vector<vector<int>> board = game->board;
+        onFinished = [callback, board](const SearchResult& result){
+            PyGILState_STATE state = PyGILState_Ensure();
+            PyObject* value = resultToPython(board, result);
+            PyObject* returned = PyObject_CallFunctionObjArgs(callback, value, nullptr);
+            if(!returned){
+                PyErr_Print();
+            }
+            Py_XDECREF(returned);
+            Py_DECREF(value);
+            Py_DECREF(callback);
+            PyGILState_Release(state);
+        };
+    }
+    vector<uint64_t> history = game->history;
+    vector<vector<int>> board = game->board;
+    Py_BEGIN_ALLOW_THREADS
+    game->search = startSearch(board, limits, history, onFinished);
+    Py_END_ALLOW_THREADS
+    Py_RETURN_NONE;
+}
+
+static PyObject* Position_best_move(PositionObject* self, PyObject*){
+    if(!self->game->search){
+        Py_RETURN_NONE;
+    }
+    return resultToPython(self->game->searchBoard, self->game->search->bestSoFar());
+}
+
+static PyObject* Position_searching(PositionObject* self, PyObject*){
+    return PyBool_FromLong(self->game->search && !self->game->search->isFinished());
+}
+
+static PyObject* Position_stop(PositionObject* self, PyObject*){
+    if(self->game->search){
+        self->game->search->stop();
+    }
+    Py_RETURN_NONE;
+}
+
+static PyObject* Position_ponderhit(PositionObject* self, PyObject*){
+    if(self->game->ponder){
+        self->game->ponder->store(false, memory_order_relaxed);
+    }
+    Py_RETURN_NONE;
+}
+
+static PyObject* Position_wait(PositionObject* self, PyObject*){
+    shared_ptr<SearchHandle> search = self->game->search;
+    if(!search){
+        Py_RETURN_NONE;
+    }
+    SearchResult result;
+    Py_BEGIN_ALLOW_THREADS
+    result = search->wait();
+    Py_END_ALLOW_THREADS
+    return resultToPython(self->game->searchBoard, result);
+}
+
+static PyMethodDef Position_methods[] = {
+    {"board", (PyCFunction)Position_board, METH_NOARGS, "The board as a list of 9 rows, the last one is the metadata."},
+    {"legal_moves", (PyCFunction)Position_legal_moves, METH_VARARGS, "The (row, column) squares the piece on a square can legally move to."},
+    {"fen", (PyCFunction)Position_fen, METH_NOARGS, "The position as FEN."},
+    {"set_fen", (PyCFunction)Position_set_fen, METH_VARARGS, "Sets up the position of a FEN, ValueError if it is invalid."},
+    {"pack", (PyCFunction)Position_pack, METH_NOARGS, "The position packed into 32 bytes."},
+    {"unpack", (PyCFunction)Position_unpack, METH_VARARGS, "Sets up a position packed by pack()."},
+    {"play", (PyCFunction)Position_play, METH_VARARGS, "Plays the move between two squares (and promotion piece), False if it is illegal."},
+    {"play_move", (PyCFunction)Position_play_move, METH_VARARGS, "Plays a move in coordinate notation (e2e4), False if it is illegal."},
+    {"status", (PyCFunction)Position_status, METH_NOARGS, "100 if the game goes on, -1 if the player to move is checkmated, 0 for a stalemate."},
+    {"in_check", (PyCFunction)Position_in_check, METH_NOARGS, "Whether the player to move is in check."},
+    {"search", (PyCFunction)(void(*)(void))Position_search, METH_VARARGS | METH_KEYWORDS, "Starts searching for the best move on another thread."},
+    {"best_move", (PyCFunction)Position_best_move, METH_NOARGS, "(move, score, depth) of the deepest finished iteration, or None."},
+    {"searching", (PyCFunction)Position_searching, METH_NOARGS, "Whether a search is still running."},
+    {"stop", (PyCFunction)Position_stop, METH_NOARGS, "Asks the running search to finish."},
+    {"ponderhit", (PyCFunction)Position_ponderhit, METH_NOARGS, "Turns a ponder search into a normal one."},
+    {"wait", (PyCFunction)Position_wait, METH_NOARGS, "Waits for the search and returns (move, score, depth)."},
+    {nullptr, nullptr, 0, nullptr}
+};
+
+static PyType_Slot positionSlots[] = {
+    {Py_tp_doc, (void*)"A chess position and its game history."},
+    {Py_tp_new, (void*)Position_new},
+    {Py_tp_init, (void*)Position_init},
+    {Py_tp_dealloc, (void*)Position_dealloc},
+    {Py_tp_methods, (void*)Position_methods},
+    {0, nullptr}
+};
+
+static PyType_Spec positionSpec = {
+    "frostweb.Position", sizeof(PositionObject), 0, Py_TPFLAGS_DEFAULT, positionSlots
+};
+
+static PyModuleDef frostwebModule = {
+    PyModuleDef_HEAD_INIT, "frostweb", "The FrostWeb chess engine.", -1, nullptr, nullptr, nullptr, nullptr, nullptr
+};
+
+PyMODINIT_FUNC PyInit_frostweb(void){
+    PyObject* module = PyModule_Create(&frostwebModule);
+    if(!module){
+        return nullptr;
+    }
+    PyObject* positionType = PyType_FromSpec(&positionSpec);
+    if(!positionType || PyModule_AddObject(module, "Position", positionType) < 0){
+        Py_XDECREF(positionType);
+        Py_DECREF(module);
+        return nullptr;
+    }
+    return module;
+}
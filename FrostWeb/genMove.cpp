@@ -4,12 +4,25 @@
  * This file provides a way for other programs to use the FrostWeb Interface
  * It is meant to be compiled with the other programs and made to an executable
  * 
+ * Engine options can be passed as `--Name value` arguments, for example
+ * `main.exe --TTFile frostweb.tt` keeps the transposition table warm between runs and
+ * `main.exe --Skill club` plays at a fixed node budget instead of the fixed depth.
+ * `main.exe --MultiPV 3` also reports the three best lines on stderr.
+ * 
+ * Mode 1 prints the best move of a board, mode 2 the state of the game. Mode 3 starts the
+ * engine server, which plays many games at once over standard input and output (see server.hpp).
+ * Mode 4 reads a FEN instead of a board and prints the FEN after the best move, or the state of
+ * the game if it is over.
+ * 
  * @author Anshuman Routray
  * @date October 11th 2024
  */
 
 #include <iostream>
 #include "search.hpp"
+#include "options.hpp"
+#include "server.hpp"
+#include "notation.hpp"
 
 using namespace std;
 
@@ -27,16 +40,84 @@ void printBoard(vector<vector<int>> board){
         cout << endl;
     }
     cout << board[8][0] << " " << board[8][1] << " " << board[8][2] << " " << board[8][3] 
-        << " " << board[8][4] << " " << board[8][5];
+        << " " << board[8][4] << " " << board[8][5] << " " << board[8][6];
+}
+
+/**
+ * Searches a board with the depth or skill level given in the options.
+ */
+SearchResult searchBoard(const vector<vector<int>>& board){
+    SearchLimits limits;
+    limits.multiPV = multiPVCount;
+    if(skillLevel.empty()){
+        limits.depth = DEPTH;
+    }
+    else {
+        applySkillLevel(skillLevel, limits);
+    }
+    return searchPosition(board, limits);
+}
+
+/**
+ * Reports the lines the search found on stderr, one per line asked for with the MultiPV option.
+ */
+void printLines(const SearchResult& result){
+    for(size_t i = 0; i < result.lines.size(); i++){
+        cerr << "info multipv " << i + 1 << " depth " << result.depth << " score " << result.lines[i].evaluation << " pv";
+        for(int move : result.lines[i].moves){
+            cerr << " " << moveName(move);
+        }
+        cerr << endl;
+    }
+}
+
+/**
+ * Reports how often the evaluation cache and the pawn table were hit. It goes to stderr so the
+ * board on stdout stays easy to parse.
+ */
+void printCacheStats(){
+    CacheStats evalCache = evalCacheStats();
+    CacheStats pawnTable = pawnTableStats();
+    cerr << "info evalcache hits " << evalCache.hits << "/" << evalCache.probes << " ("
+        << (evalCache.probes ? 100.0 * evalCache.hits / evalCache.probes : 0.0) << "%) pawntable hits "
+        << pawnTable.hits << "/" << pawnTable.probes << " ("
+        << (pawnTable.probes ? 100.0 * pawnTable.hits / pawnTable.probes : 0.0) << "%)" << endl;
 }
 
-int main(){
- 
+int main(int argc, char* argv[]){
+
+    parseOptions(argc, argv);
+
     vector<vector<int>> inputBoard;
     int mode;
 
     cin >> mode;
 
+    if(mode == 3){
+        runServer(threadCount);
+        return 0;
+    }
+
+    if(mode == 4){
+        string fen;
+        int fullMoves;
+        getline(cin >> ws, fen);
+        inputBoard = boardFromFen(fen, &fullMoves);
+        if(inputBoard.empty()){
+            cerr << "Invalid FEN" << endl;
+            return 1;
+        }
+        SearchResult result = searchBoard(inputBoard);
+        if(result.bestBoard.size() == 1){
+            cout << result.bestBoard[0][0];
+        }
+        else {
+            cout << boardToFen(result.bestBoard, fullMoves + (inputBoard[8][2] == blackPlayer));
+        }
+        printLines(result);
+        return 0;
+    }
+
     for(int i = 0; i < 8; i++){
         vector<int> row;
         for(int j = 0; j < 8; j++){
@@ -49,8 +130,10 @@ int main(){
 
     vector<int> row2;
 
-    for(int i = 0; i < 6; i++){
-        int x;
+    //Older inputs stop after the En Passant flag, the half move clock then reads as 0
+
+    for(int i = 0; i < 7; i++){
+        int x = 0;
         cin >> x;
         row2.push_back(x);
     }
@@ -58,22 +141,13 @@ int main(){
     inputBoard.push_back(row2);
 
     if(mode == 1){
-        printBoard(getBestMove(inputBoard, DEPTH));
+        SearchResult result = searchBoard(inputBoard);
+        printBoard(result.bestBoard);
+        printLines(result);
+        printCacheStats();
     }
     else if (mode == 2){
-        int moves = generateMoves(inputBoard).size();
-        if(moves == 0){
-            pair<int, int> kingPos = retrieveKingPosition(inputBoard, inputBoard[8][2]);
-            if(isAttacked(inputBoard, kingPos)){
-                cout << -1;
-            }
-            else {
-                cout << 0;
-            }
-        }
-        else {
-            cout << 100;
-        }
+        cout << gameStatus(inputBoard);
     }
     return 0; 
 } 
\ No newline at end of file
@@ -0,0 +1,144 @@
+/**
+ * @brief Load test for the engine server
+ *
+ * Runs the server in process with more and more games at once and reports how long the
+ * games wait for their moves. Every game asks for a move, plays it and asks again, so the
+ * engine plays both sides. Latency is measured from sending `go` to receiving `bestmove`,
+ * which includes the time spent waiting for a free worker. Next to the latency it reports the
+ * depth the replies reached and how many root moves they searched at that depth, so a reply that
+ * only waited in the queue until its time was up shows how little it looked at. `partial` counts
+ * the replies that searched fewer root moves than there are legal moves, which only a mate in one
+ * should cause.
+ *
+ * It is meant to be compiled like genMove.cpp, with every file that has no main function.
+ * Engine options work the same way, `loadTest.exe --Threads 4` sets the number of workers.
+ *
+ * @author Anshuman Routray
+ */
+
+#include <cstdio>
+#include <iostream>
+#include <sstream>
+#include "server.hpp"
+#include "board.hpp"
+#include "options.hpp"
+
+using namespace std;
+
+const int BUDGET = 50; //Milliseconds per move
+const int MOVES = 6; //Moves each game asks for
+const int SESSIONS[] = {1, 2, 4, 8, 16, 32}; //Number of games played at once
+
+//Replies arrive on the worker threads, they are handed to the main thread through this queue
+
+mutex replyLock;
+condition_variable replyReady;
+deque<string> replies;
+
+double percentile(vector<double>& latencies, double fraction){
+    size_t index = min(latencies.size() - 1, (size_t)(fraction * latencies.size()));
+    nth_element(latencies.begin(), latencies.begin() + index, latencies.end());
+    return latencies[index];
+}
+
+double average(const vector<int>& values){
+    double sum = 0;
+    for(int value : values){
+        sum += value;
+    }
+    return values.empty() ? 0.0 : sum / values.size();
+}
+
+int main(int argc, char* argv[]){
+
+    parseOptions(argc, argv);
+
+    EngineServer server(threadCount, [](const string& line){
+        lock_guard<mutex> guard(replyLock);
+        replies.push_back(line);
+        replyReady.notify_one();
+    });
+
+    cout << "workers " << threadCount << " budget " << BUDGET << "ms" << endl;
+    cout << "sessions     p50     p90     p99     max  (ms)   depth min  avg   root moves min   avg  partial" << endl;
+
+    for(int sessionCount : SESSIONS){
+        map<string, chrono::steady_clock::time_point> sent;
+        map<string, int> movesLeft;
+        vector<double> latencies;
+        map<string, vector<vector<int>>> boards;
+        vector<int> depths, rootMoves;
+        int partial = 0;
+
+        for(int i = 0; i < sessionCount; i++){
+            string id = "game" + to_string(i);
+            server.handleCommand(id + " position startpos");
+            server.handleCommand(id + " budget " + to_string(BUDGET));
+            movesLeft[id] = MOVES;
+            boards[id] = startingBoard;
+            sent[id] = chrono::steady_clock::now();
+            server.handleCommand(id + " go");
+        }
+
+        int playing = sessionCount;
+        while(playing > 0){
+            string line;
+            {
+                unique_lock<mutex> guard(replyLock);
+                replyReady.wait(guard, []{ return !replies.empty(); });
+                line = replies.front();
+                replies.pop_front();
+            }
+            istringstream reply(line);
+            string id, type, move;
+            reply >> id >> type >> move;
+            if(type == "info"){
+                continue;
+            }
+            if(type != "bestmove"){
+                cerr << "UNEXPECTED REPLY: " << line << endl;
+                continue;
+            }
+            chrono::duration<double, milli> latency = chrono::steady_clock::now() - sent[id];
+            latencies.push_back(latency.count());
+
+            //The rest of the reply is names followed by values, a move from the book or the tablebases
+            //ends with one more word and was not searched
+
+            string name, value;
+            int depth = -1, searched = 0;
+            while(reply >> name >> value){
+                if(name == "depth"){
+                    depth = stoi(value);
+                }
+                else if(name == "rootmoves"){
+                    searched = stoi(value);
+                }
+            }
+            if(name != "book" && name != "tablebase" && depth >= 0){
+                depths.push_back(depth);
+                rootMoves.push_back(searched);
+                partial += move != "none" && searched < (int)generateMoves(boards[id]).size();
+            }
+
+            //A game that is already over has no move to play and ends early
+
+            if(--movesLeft[id] == 0 || move == "none"){
+                server.handleCommand(id + " quit");
+                playing--;
+                continue;
+            }
+            boards[id] = findMove(boards[id], move);
+            server.handleCommand(id + " move " + move);
+            sent[id] = chrono::steady_clock::now();
+            server.handleCommand(id + " go");
+        }
+
+        double maxLatency = *max_element(latencies.begin(), latencies.end());
+        printf("%8d %7.1f %7.1f %7.1f %7.1f        %9d %4.1f %14d %5.1f %8d\n", sessionCount, percentile(latencies, 0.5),
+            percentile(latencies, 0.9), percentile(latencies, 0.99), maxLatency,
+            depths.empty() ? 0 : *min_element(depths.begin(), depths.end()), average(depths),
+            rootMoves.empty() ? 0 : *min_element(rootMoves.begin(), rootMoves.end()), average(rootMoves), partial);
+    }
+    return 0;
+}
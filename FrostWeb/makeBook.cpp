@@ -0,0 +1,382 @@
+/**
+ * @brief Builds a Polyglot opening book from the games of a PGN file
+ *
+ * The file is read one game at a time and never held in memory, so archives of any size can be
+ * used, and `-` reads the games from standard input (for example from `zcat games.pgn.gz`).
+ * Games are handed out in batches to a pool of workers, which replay the moves with the engine's
+ * own move generator and count every move of the first plies of each game. The counts are kept in
+ * SHARD_COUNT shards, split by the first bits of the Polyglot key, each with its own lock, so the
+ * workers rarely wait for each other. Because the shards split the keys in order, writing them one
+ * after another gives a file sorted by key, as Polyglot books have to be (see book.hpp).
+ *
+ * The weight of a move is two points for every game won by the player who made it and one for
+ * every draw, games without a result count as draws. Moves played in fewer than MIN_GAMES games
+ * or that never scored are left out. A game stops counting at its first move that cannot be read
+ * or is not legal, and games that start from a FEN tag start from that position.
+ *
+ * Books are keyed with Polyglot's published numbers, so other programs read them. Positions whose
+ * key needs one of the numbers FrostWeb does not have (see book.hpp) are left out, unless the full
+ * list is loaded with `--BookKeys <file>`, and the key of the start position in the finished book
+ * is checked against Polyglot's 463b96181691fc9c.
+ *
+ * Usage: `makeBook.exe <pgn> <book> <plies>` followed by engine options like `--Threads 8`.
+ *
+ * It is meant to be compiled like genMove.cpp, with every file that has no main function.
+ *
+ * @author Anshuman Routray
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include "book.hpp"
+#include "notation.hpp"
+#include "options.hpp"
+
+using namespace std;
+
+const int SHARD_BITS = 6; //The first bits of the key choose the shard
+const int SHARD_COUNT = 1 << SHARD_BITS;
+const size_t BATCH_GAMES = 256; //Games handed to a worker at a time
+const uint32_t MIN_GAMES = 2; //Games a move has to be played in to be in the book
+const uint64_t PROGRESS_GAMES = 100000; //Games between progress reports
+const uint64_t POLYGLOT_START_KEY = 0x463b96181691fc9cULL; //Key of the start position with Polyglot's numbers
+
+struct PgnGame {
+    string fen;
+    string moveText;
+    int result = 0; //1 if white won, -1 if black won, 0 otherwise
+};
+
+struct MoveKey {
+    uint64_t key;
+    uint16_t move;
+
+    bool operator==(const MoveKey& other) const {
+        return key == other.key && move == other.move;
+    }
+};
+
+struct MoveKeyHash {
+    size_t operator()(const MoveKey& moveKey) const {
+        return (size_t)(moveKey.key ^ (moveKey.move * 0x9E3779B97F4A7C15ULL));
+    }
+};
+
+struct MoveCount {
+    uint32_t games = 0;
+    uint32_t points = 0;
+};
+
+struct Shard {
+    mutex lock;
+    unordered_map<MoveKey, MoveCount, MoveKeyHash> moves;
+};
+
+Shard shards[SHARD_COUNT];
+atomic<uint64_t> gamesDone(0), gamesBroken(0), movesCounted(0), movesUnpublished(0);
+
+/**
+ * Splits movetext into its moves, leaving out move numbers, comments, variations, annotations
+ * and the result.
+ */
+vector<string> sanMoves(const string& moveText){
+    vector<string> moves;
+    string word;
+    int variationDepth = 0;
+    auto endWord = [&](){
+        size_t start = word.find_first_not_of("0123456789.");
+        if(variationDepth == 0 && start != string::npos && word[0] != '$'
+            && word != "1-0" && word != "0-1" && word != "1/2-1/2" && word != "*"){
+            moves.push_back(word.substr(start));
+        }
+        word.clear();
+    };
+    for(size_t i = 0; i < moveText.size(); i++){
+        char symbol = moveText[i];
+        if(symbol == '{'){
+            endWord();
+            i = min(moveText.find('}', i), moveText.size());
+        }
+        else if(symbol == ';'){
+            endWord();
+            i = min(moveText.find('\n', i), moveText.size());
+        }
+        else if(symbol == '('){
+            endWord();
+            variationDepth++;
+        }
+        else if(symbol == ')'){
+            endWord();
+            variationDepth = max(0, variationDepth - 1);
+        }
+        else if(isspace((unsigned char)symbol)){
+            endWord();
+        }
+        else {
+            word += symbol;
+        }
+    }
+    endWord();
+    return moves;
+}
+
+/**
+ * Replays a batch of games and adds their moves to the shards.
+ */
+void countGames(const vector<PgnGame>& games, int plies){
+    vector<pair<MoveKey, uint32_t>> counted;
+    for(const PgnGame& game : games){
+        vector<vector<int>> board = game.fen.empty() ? startingBoard : boardFromFen(game.fen);
+        vector<string> moves = sanMoves(game.moveText);
+        bool broken = board.empty();
+        for(int ply = 0; ply < plies && ply < (int)moves.size() && !broken; ply++){
+            vector<vector<int>> newBoard = findSanMove(board, moves[ply]);
+            if(newBoard.empty()){
+                broken = true;
+                break;
+            }
+
+            //Other programs would not find a position under a key of FrostWeb's own numbers
+
+            if(!hasPublishedKey(board)){
+                movesUnpublished++;
+                board = newBoard;
+                continue;
+            }
+            int points = 1 + game.result * board[8][2];
+            counted.push_back({{polyglotKey(board), toPolyglotMove(board, encodeMove(board, newBoard))}, (uint32_t)points});
+            board = newBoard;
+        }
+        gamesBroken += broken;
+    }
+
+    //Every shard is locked once per batch
+
+    sort(counted.begin(), counted.end(), [](const pair<MoveKey, uint32_t>& a, const pair<MoveKey, uint32_t>& b){
+        return a.first.key < b.first.key;
+    });
+    for(size_t i = 0; i < counted.size();){
+        int shard = (int)(counted[i].first.key >> (64 - SHARD_BITS));
+        lock_guard<mutex> guard(shards[shard].lock);
+        for(; i < counted.size() && (int)(counted[i].first.key >> (64 - SHARD_BITS)) == shard; i++){
+            MoveCount& count = shards[shard].moves[counted[i].first];
+            count.games++;
+            count.points += counted[i].second;
+        }
+    }
+    movesCounted += counted.size();
+    gamesDone += games.size();
+}
+
+static void writeBigEndian(unsigned char* bytes, uint64_t value, int count){
+    for(int i = count - 1; i >= 0; i--){
+        bytes[i] = (unsigned char)value;
+        value >>= 8;
+    }
+}
+
+/**
+ * Writes the moves of every shard, in order of key and the best moves of a position first.
+ *
+ * @return The number of entries written, or -1 if the file could not be written.
+ */
+int64_t writeBook(const string& path){
+    FILE* file = fopen(path.c_str(), "wb");
+    if(!file){
+        return -1;
+    }
+    int64_t written = 0;
+    bool failed = false;
+    for(Shard& shard : shards){
+        vector<pair<MoveKey, MoveCount>> entries;
+        for(const pair<const MoveKey, MoveCount>& entry : shard.moves){
+            if(entry.second.games >= MIN_GAMES && entry.second.points > 0){
+                entries.push_back(entry);
+            }
+        }
+        shard.moves.clear();
+        sort(entries.begin(), entries.end(), [](const pair<MoveKey, MoveCount>& a, const pair<MoveKey, MoveCount>& b){
+            if(a.first.key != b.first.key){
+                return a.first.key < b.first.key;
+            }
+            return (a.second.points != b.second.points) ? a.second.points > b.second.points : a.first.move < b.first.move;
+        });
+
+        //Weights have 16 bits, the moves of a position are scaled down together if the best has more points
+
+        vector<unsigned char> bytes(entries.size() * 16, 0);
+        for(size_t first = 0; first < entries.size();){
+            size_t last = first;
+            while(last < entries.size() && entries[last].first.key == entries[first].first.key){
+                last++;
+            }
+            uint32_t most = entries[first].second.points;
+            for(size_t i = first; i < last; i++){
+                uint32_t weight = (most > 65535) ? (uint32_t)((uint64_t)entries[i].second.points * 65535 / most) : entries[i].second.points;
+                unsigned char* entry = &bytes[i * 16];
+                writeBigEndian(entry, entries[i].first.key, 8);
+                writeBigEndian(entry + 8, entries[i].first.move, 2);
+                writeBigEndian(entry + 10, max(1u, weight), 2);
+            }
+            first = last;
+        }
+        failed = failed || fwrite(bytes.data(), 1, bytes.size(), file) != bytes.size();
+        written += entries.size();
+    }
+    failed = (fclose(file) != 0) || failed;
+    return failed ? -1 : written;
+}
+
+int main(int argc, char* argv[]){
+
+    if(argc < 4){
+        cerr << "Usage: " << argv[0] << " <pgn> <book> <plies> [--Name value ...]" << endl;
+        return 1;
+    }
+    string pgnPath = argv[1];
+    int plies = max(1, atoi(argv[3]));
+    parseOptions(argc - 3, argv + 3);
+
+    ifstream pgnFile;
+    if(pgnPath != "-"){
+        pgnFile.open(pgnPath);
+        if(!pgnFile){
+            cerr << "Could not open " << pgnPath << endl;
+            return 1;
+        }
+    }
+    istream& input = (pgnPath == "-") ? cin : pgnFile;
+
+    //At most two batches per worker wait in the queue, so memory does not grow with the file
+
+    mutex queueLock;
+    condition_variable queueChanged;
+    deque<vector<PgnGame>> batches;
+    bool reading = true;
+    vector<thread> workers;
+    for(int i = 0; i < threadCount; i++){
+        workers.emplace_back([&](){
+            while(true){
+                vector<PgnGame> batch;
+                {
+                    unique_lock<mutex> guard(queueLock);
+                    queueChanged.wait(guard, [&]{ return !batches.empty() || !reading; });
+                    if(batches.empty()){
+                        return;
+                    }
+                    batch = move(batches.front());
+                    batches.pop_front();
+                }
+                queueChanged.notify_all();
+                countGames(batch, plies);
+            }
+        });
+    }
+    auto queueBatch = [&](vector<PgnGame>& batch){
+        unique_lock<mutex> guard(queueLock);
+        queueChanged.wait(guard, [&]{ return batches.size() < 2 * (size_t)threadCount; });
+        batches.push_back(move(batch));
+        batch.clear();
+        guard.unlock();
+        queueChanged.notify_all();
+    };
+
+    //A game is its tag pairs followed by its movetext, a tag after movetext starts the next game
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    vector<PgnGame> batch;
+    PgnGame game;
+    bool inMoves = false;
+    uint64_t gamesRead = 0, bytesRead = 0;
+    string line;
+    auto endGame = [&](){
+        if(inMoves){
+            batch.push_back(move(game));
+            gamesRead++;
+            if(batch.size() >= BATCH_GAMES){
+                queueBatch(batch);
+            }
+            if(gamesRead % PROGRESS_GAMES == 0){
+                double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+                cout << "games " << gamesRead << ", " << (uint64_t)(bytesRead / max(seconds, 1e-9) / 1e6) << " MB/s" << endl;
+            }
+        }
+        game = PgnGame();
+        inMoves = false;
+    };
+    while(getline(input, line)){
+        bytesRead += line.size() + 1;
+        if(!line.empty() && line.back() == '\r'){
+            line.pop_back();
+        }
+        size_t first = line.find_first_not_of(" \t");
+        if(first == string::npos){
+            continue;
+        }
+        if(line[first] == '[' && line.back() == ']' && line.find('"') != string::npos){
+            if(inMoves){
+                endGame();
+            }
+            size_t quote = line.find('"'), endQuote = line.rfind('"');
+            string tag = line.substr(first + 1, line.find_first_of(" \t", first) - first - 1);
+            string value = (quote != endQuote) ? line.substr(quote + 1, endQuote - quote - 1) : "";
+            if(tag == "FEN"){
+                game.fen = value;
+            }
+            else if(tag == "Result"){
+                game.result = (value == "1-0") ? 1 : (value == "0-1") ? -1 : 0;
+            }
+            continue;
+        }
+        game.moveText += line;
+        game.moveText += '\n';
+        inMoves = true;
+    }
+    endGame();
+    if(!batch.empty()){
+        queueBatch(batch);
+    }
+    {
+        lock_guard<mutex> guard(queueLock);
+        reading = false;
+    }
+    queueChanged.notify_all();
+    for(thread& worker : workers){
+        worker.join();
+    }
+
+    int64_t entries = writeBook(argv[2]);
+    if(entries < 0){
+        cerr << "Could not write " << argv[2] << endl;
+        return 1;
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    //Other programs only find the moves if the book uses Polyglot's numbers
+
+    OpeningBook book;
+    if(book.open(argv[2]) && !book.probe(startingBoard).empty()){
+        uint64_t startKey = polyglotKey(startingBoard);
+        if(startKey != POLYGLOT_START_KEY){
+            cerr << "Warning: the start position has key " << hex << startKey << " instead of Polyglot's "
+                << POLYGLOT_START_KEY << dec << ", only FrostWeb can read this book, check the numbers given with --BookKeys" << endl;
+        }
+        else {
+            cout << "start position key " << hex << startKey << dec << ", the book uses Polyglot's numbers" << endl;
+        }
+    }
+    cout << "games " << gamesDone << " (" << gamesBroken << " with unreadable moves), moves " << movesCounted
+        << " (" << movesUnpublished << " more left out without a published key)"
+        << ", book entries " << entries << " in " << seconds << "s, " << gamesDone / max(seconds, 1e-9)
+        << " games/s, workers " << threadCount << endl;
+    return 0;
+}
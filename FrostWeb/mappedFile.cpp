@@ -0,0 +1,154 @@
+/**
+ * @file mappedFile.cpp
+ * @brief Implementation of the memory-mapped file wrapper for Windows and POSIX systems.
+ * 
+ * @author Anshuman Routray
+ */
+
+#include "mappedFile.hpp"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+MappedFile::~MappedFile(){
+    close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(const string& path, size_t size, bool writable){
+    close();
+    this->writable = writable;
+    HANDLE file = CreateFileA(path.c_str(), writable ? (GENERIC_READ | GENERIC_WRITE) : GENERIC_READ,
+        FILE_SHARE_READ | (writable ? 0 : FILE_SHARE_WRITE), nullptr, writable ? OPEN_ALWAYS : OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL, nullptr);
+    if(file == INVALID_HANDLE_VALUE){
+        return false;
+    }
+
+    //The lock covers a byte far past the end of the file, locks on the mapped bytes would block the mapping itself
+
+    if(writable){
+        OVERLAPPED lockRange = {};
+        lockRange.Offset = 0xFFFFFFFF;
+        lockRange.OffsetHigh = 0x7FFFFFFF;
+        if(!LockFileEx(file, LOCKFILE_EXCLUSIVE_LOCK | LOCKFILE_FAIL_IMMEDIATELY, 0, 1, 0, &lockRange)){
+            CloseHandle(file);
+            return false;
+        }
+    }
+    else {
+        LARGE_INTEGER fileSize;
+        if(!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0){
+            CloseHandle(file);
+            return false;
+        }
+        size = (size_t)fileSize.QuadPart;
+    }
+    HANDLE mapping = CreateFileMappingA(file, nullptr, writable ? PAGE_READWRITE : PAGE_READONLY,
+        (DWORD)((unsigned long long)size >> 32), (DWORD)(size & 0xFFFFFFFFULL), nullptr);
+    if(mapping == nullptr){
+        CloseHandle(file);
+        return false;
+    }
+    void* view = MapViewOfFile(mapping, writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, size);
+    if(view == nullptr){
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+    fileHandle = file;
+    mappingHandle = mapping;
+    memory = (unsigned char*)view;
+    length = size;
+    return true;
+}
+
+void MappedFile::flush(){
+    if(memory != nullptr && writable){
+        FlushViewOfFile(memory, length);
+        FlushFileBuffers((HANDLE)fileHandle);
+    }
+}
+
+void MappedFile::close(){
+    if(memory == nullptr){
+        return;
+    }
+    flush();
+    UnmapViewOfFile(memory);
+    CloseHandle((HANDLE)mappingHandle);
+    CloseHandle((HANDLE)fileHandle);
+    memory = nullptr;
+    length = 0;
+    fileHandle = nullptr;
+    mappingHandle = nullptr;
+}
+
+#else
+
+bool MappedFile::open(const string& path, size_t size, bool writable){
+    close();
+    this->writable = writable;
+    int descriptor = ::open(path.c_str(), writable ? (O_RDWR | O_CREAT) : O_RDONLY, 0644);
+    if(descriptor < 0){
+        return false;
+    }
+    if(writable){
+
+        //The lock is taken before resizing, which would pull the file out from under another process
+
+        if(flock(descriptor, LOCK_EX | LOCK_NB) != 0 || ftruncate(descriptor, (off_t)size) != 0){
+            ::close(descriptor);
+            return false;
+        }
+    }
+    else {
+        struct stat fileInfo;
+        if(fstat(descriptor, &fileInfo) != 0 || fileInfo.st_size == 0){
+            ::close(descriptor);
+            return false;
+        }
+        size = (size_t)fileInfo.st_size;
+    }
+    void* view = mmap(nullptr, size, writable ? (PROT_READ | PROT_WRITE) : PROT_READ, MAP_SHARED, descriptor, 0);
+    if(view == MAP_FAILED){
+        ::close(descriptor);
+        return false;
+    }
+    fileDescriptor = descriptor;
+    memory = (unsigned char*)view;
+    length = size;
+    return true;
+}
+
+void MappedFile::flush(){
+    if(memory != nullptr && writable){
+        msync(memory, length, MS_SYNC);
+    }
+}
+
+void MappedFile::close(){
+    if(memory == nullptr){
+        return;
+    }
+    flush();
+    munmap(memory, length);
+    ::close(fileDescriptor);
+    memory = nullptr;
+    length = 0;
+    fileDescriptor = -1;
+}
+
+#endif
@@ -0,0 +1,71 @@
+/**
+ * @file mappedFile.hpp
+ * @brief Declaration of a small wrapper around memory-mapped files.
+ * 
+ * Mapping a file lets the engine use its contents directly from the operating system's page
+ * cache, without reading or parsing it first. Writable mappings are shared with the file, so
+ * changes end up on disk when the mapping is flushed or closed. A writable mapping holds an
+ * advisory lock on its file (flock or LockFileEx) until it is closed, so two processes never
+ * write to the same file at once.
+ * 
+ * @author Anshuman Routray
+ */
+
+#ifndef MAPPEDFILE_HPP
+#define MAPPEDFILE_HPP
+
+#include <cstddef>
+#include <string>
+
+using namespace std;
+
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /**
+     * @brief Maps a file into memory.
+     * 
+     * @param path: The path of the file
+     * 
+     * @param size: For writable mappings, the size the file is created or resized to.
+     * Read-only mappings ignore it and map the whole file.
+     * 
+     * @param writable: Whether changes to the mapped memory should be written to the file
+     * 
+     * @return True if the file was mapped, otherwise false, also for writable mappings of a file
+     * another process has mapped writable.
+     */
+    bool open(const string& path, size_t size, bool writable);
+
+    /**
+     * @brief Writes the changed pages back to the file and unmaps it.
+     */
+    void close();
+
+    /**
+     * @brief Writes the changed pages back to the file, keeping it mapped.
+     */
+    void flush();
+
+    unsigned char* data() const { return memory; }
+    size_t size() const { return length; }
+    bool isOpen() const { return memory != nullptr; }
+
+private:
+    unsigned char* memory = nullptr;
+    size_t length = 0;
+    bool writable = false;
+#ifdef _WIN32
+    void* fileHandle = nullptr;
+    void* mappingHandle = nullptr;
+#else
+    int fileDescriptor = -1;
+#endif
+};
+
+#endif
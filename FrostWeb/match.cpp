@@ -0,0 +1,614 @@
+/**
+ * @brief Plays two engines against each other and reports the Elo difference between them
+ *
+ * Both engines are started once, in server mode (mode 3 of genMove.cpp, see server.hpp), and
+ * every game is a session in both of them, so many games run at the same time. Each opening is
+ * played twice, with the colours swapped. Games are judged here and not by the engines: a game
+ * ends in checkmate, stalemate, threefold repetition, the fifty move rule or after MAX_PLIES moves
+ * (a draw). An engine that plays an illegal move, replies with an error or does not reply in time
+ * loses the game.
+ *
+ * After every game the score of the first engine is turned into an Elo difference with its 95%
+ * error bars, and a sequential probability ratio test between "the first engine is elo0 stronger"
+ * and "the first engine is elo1 stronger" is updated. The match stops early once the test accepts
+ * one of them, with false positives and false negatives both at 5%.
+ *
+ * Usage: `match.exe <engine1> <engine2> <games> movetime <ms>` or `... nodes <count>`, where an
+ * engine is a command line like "main.exe --Skill club", followed by options of the match:
+ * - `--Openings <file>`: FEN or EPD positions to start from, used in order. Without a file every
+ *   pair of games starts with RANDOM_PLIES random moves from the starting position
+ * - `--Concurrency <n>`: Games played at the same time, by default the number of cores
+ * - `--Elo0 <elo>` and `--Elo1 <elo>`: The hypotheses of the test, by default 0 and 5
+ *
+ * Each engine searches with its own `--Threads` workers, the concurrency should leave every game
+ * a core so that time controls stay fair.
+ *
+ * It is meant to be compiled like genMove.cpp, with every file that has no main function.
+ *
+ * @author Anshuman Routray
+ */
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <csignal>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <thread>
+#include "notation.hpp"
+#include "zobrist.hpp"
+
+using namespace std;
+
+const int MAX_PLIES = 400; //Moves after which a game is a draw
+const int RANDOM_PLIES = 8; //Random moves of an opening when no file is given
+const int TIMEOUT_MARGIN = 1000; //Milliseconds a reply may be late before the engine loses
+const int NODES_TIMEOUT = 60000; //Milliseconds a search with a node limit may take
+const double SPRT_ERROR = 0.05; //Chance of accepting the wrong hypothesis
+
+/**
+ * An engine running in another process, talked to over its standard input and output.
+ */
+class EngineProcess {
+public:
+    ~EngineProcess(){
+        stop();
+    }
+
+    /**
+     * Starts the engine. The command is split at spaces, double quotes keep a part together.
+     */
+    bool start(const string& command){
+#ifdef _WIN32
+        SECURITY_ATTRIBUTES security{sizeof(security), nullptr, TRUE};
+        HANDLE childInput, childOutput;
+        if(!CreatePipe(&childInput, &input, &security, 0)){
+            return false;
+        }
+        if(!CreatePipe(&output, &childOutput, &security, 0)){
+            CloseHandle(childInput);
+            CloseHandle(input);
+            return false;
+        }
+        SetHandleInformation(input, HANDLE_FLAG_INHERIT, 0);
+        SetHandleInformation(output, HANDLE_FLAG_INHERIT, 0);
+
+        STARTUPINFOA startup{};
+        startup.cb = sizeof(startup);
+        startup.dwFlags = STARTF_USESTDHANDLES;
+        startup.hStdInput = childInput;
+        startup.hStdOutput = childOutput;
+        startup.hStdError = GetStdHandle(STD_ERROR_HANDLE);
+        PROCESS_INFORMATION started;
+        string commandLine = command;
+        bool created = CreateProcessA(nullptr, &commandLine[0], nullptr, nullptr, TRUE, 0, nullptr, nullptr, &startup, &started);
+        CloseHandle(childInput);
+        CloseHandle(childOutput);
+        if(!created){
+            CloseHandle(input);
+            CloseHandle(output);
+            return false;
+        }
+        CloseHandle(started.hThread);
+        process = started.hProcess;
+#else
+        vector<string> arguments;
+        string argument;
+        bool quoted = false, any = false;
+        for(char c : command){
+            if(c == '"'){
+                quoted = !quoted;
+                any = true;
+            }
+            else if(c == ' ' && !quoted){
+                if(any){
+                    arguments.push_back(argument);
+                }
+                argument.clear();
+                any = false;
+            }
+            else {
+                argument += c;
+                any = true;
+            }
+        }
+        if(any){
+            arguments.push_back(argument);
+        }
+        if(arguments.empty()){
+            return false;
+        }
+
+        int toChild[2], fromChild[2];
+        if(pipe(toChild) != 0){
+            return false;
+        }
+        if(pipe(fromChild) != 0){
+            ::close(toChild[0]);
+            ::close(toChild[1]);
+            return false;
+        }
+        process = fork();
+        if(process == 0){
+            dup2(toChild[0], 0);
+            dup2(fromChild[1], 1);
+            ::close(toChild[0]);
+            ::close(toChild[1]);
+            ::close(fromChild[0]);
+            ::close(fromChild[1]);
+            vector<char*> argv;
+            for(string& part : arguments){
+                argv.push_back(&part[0]);
+            }
+            argv.push_back(nullptr);
+            execvp(argv[0], argv.data());
+            _exit(127);
+        }
+        ::close(toChild[0]);
+        ::close(fromChild[1]);
+        if(process < 0){
+            ::close(toChild[1]);
+            ::close(fromChild[0]);
+            return false;
+        }
+        input = toChild[1];
+        output = fromChild[0];
+#endif
+        running = true;
+        return true;
+    }
+
+    /**
+     * Sends one line, it can be called from any thread.
+     */
+    bool send(const string& line){
+        lock_guard<mutex> guard(sendLock);
+        if(!running){
+            return false;
+        }
+        string data = line + "\n";
+        size_t written = 0;
+        while(written < data.size()){
+#ifdef _WIN32
+            DWORD count;
+            if(!WriteFile(input, data.data() + written, (DWORD)(data.size() - written), &count, nullptr)){
+                return false;
+            }
+#else
+            ssize_t count = write(input, data.data() + written, data.size() - written);
+            if(count <= 0){
+                return false;
+            }
+#endif
+            written += count;
+        }
+        return true;
+    }
+
+    /**
+     * Reads one line without the newline, false once the engine closed its output.
+     */
+    bool readLine(string& line){
+        size_t end;
+        while((end = buffer.find('\n')) == string::npos){
+            char chunk[4096];
+#ifdef _WIN32
+            DWORD count;
+            if(!ReadFile(output, chunk, sizeof(chunk), &count, nullptr) || count == 0){
+                return false;
+            }
+#else
+            ssize_t count = read(output, chunk, sizeof(chunk));
+            if(count <= 0){
+                return false;
+            }
+#endif
+            buffer.append(chunk, count);
+        }
+        line = buffer.substr(0, end);
+        buffer.erase(0, end + 1);
+        if(!line.empty() && line.back() == '\r'){
+            line.pop_back();
+        }
+        return true;
+    }
+
+    /**
+     * Tells the engine to quit and waits for it to exit.
+     */
+    void stop(){
+        {
+            lock_guard<mutex> guard(sendLock);
+            if(!running){
+                return;
+            }
+            running = false;
+        }
+#ifdef _WIN32
+        DWORD count;
+        WriteFile(input, "quit\n", 5, &count, nullptr);
+        CloseHandle(input);
+        WaitForSingleObject(process, INFINITE);
+        CloseHandle(process);
+        CloseHandle(output);
+#else
+        if(write(input, "quit\n", 5) < 0){
+            kill(process, SIGTERM);
+        }
+        ::close(input);
+        waitpid(process, nullptr, 0);
+        ::close(output);
+#endif
+    }
+
+private:
+#ifdef _WIN32
+    HANDLE input = nullptr, output = nullptr, process = nullptr;
+#else
+    int input = -1, output = -1;
+    pid_t process = -1;
+#endif
+    bool running = false;
+    mutex sendLock;
+    string buffer;
+};
+
+/**
+ * The replies of both engines, sorted by engine and game so every game waits only for its own.
+ */
+struct Mailbox {
+    mutex lock;
+    condition_variable arrived;
+    map<pair<int, string>, deque<string>> replies;
+    bool closed[2] = {false, false};
+};
+
+Mailbox mailbox;
+EngineProcess engines[2];
+
+/**
+ * Reads the replies of an engine until it exits. Replies of games that are over and the lines
+ * of the principal variations are dropped.
+ */
+void readReplies(int engine){
+    string line;
+    while(engines[engine].readLine(line)){
+        istringstream words(line);
+        string id, kind;
+        words >> id >> kind;
+        if(kind == "info"){
+            continue;
+        }
+        lock_guard<mutex> guard(mailbox.lock);
+        auto found = mailbox.replies.find({engine, id});
+        if(found != mailbox.replies.end()){
+            found->second.push_back(line);
+            mailbox.arrived.notify_all();
+        }
+    }
+    lock_guard<mutex> guard(mailbox.lock);
+    mailbox.closed[engine] = true;
+    mailbox.arrived.notify_all();
+}
+
+/**
+ * Waits for the next reply of an engine to a game. It is empty if none came before the deadline.
+ */
+string waitReply(int engine, const string& id, chrono::steady_clock::time_point deadline){
+    unique_lock<mutex> guard(mailbox.lock);
+    deque<string>& replies = mailbox.replies[{engine, id}];
+    mailbox.arrived.wait_until(guard, deadline, [&]{ return !replies.empty() || mailbox.closed[engine]; });
+    if(replies.empty()){
+        return "";
+    }
+    string reply = replies.front();
+    replies.pop_front();
+    return reply;
+}
+
+struct GameResult {
+    int score; //1 if white won, -1 if black won, 0 for a draw
+    string reason;
+    int plies;
+};
+
+/**
+ * Plays one game from an opening. The engine at index 0 of players has white.
+ */
+GameResult playGame(int game, const vector<vector<int>>& opening, const int players[2], const string& limit, int timeout){
+    string id = "g" + to_string(game);
+    {
+        lock_guard<mutex> guard(mailbox.lock);
+        mailbox.replies[{0, id}].clear();
+        mailbox.replies[{1, id}].clear();
+    }
+    string fen = boardToFen(opening);
+    for(EngineProcess& engine : engines){
+        engine.send(id + " position fen " + fen);
+    }
+
+    vector<vector<int>> board = opening;
+    vector<uint64_t> history;
+    GameResult result{0, "", 0};
+    for(int ply = 0; result.reason.empty(); ply++){
+        uint64_t key = zobristKey(board);
+        int status = gameStatus(board);
+        if(status == checkmated){
+            result = {-board[8][2], "checkmate", ply};
+            break;
+        }
+        if(status == stalemated || board[8][6] >= 100 || count(history.begin(), history.end(), key) >= 2 || ply >= MAX_PLIES){
+            result.reason = (status == stalemated) ? "stalemate" : (board[8][6] >= 100) ? "fifty moves"
+                : (ply >= MAX_PLIES) ? "move limit" : "repetition";
+            result.plies = ply;
+            break;
+        }
+
+        //Earlier errors of the engine, like a rejected move, are read here too and lose the game
+
+        int side = (board[8][2] == whitePlayer) ? 0 : 1;
+        int engine = players[side];
+        engines[engine].send(id + " go " + limit);
+        string reply = waitReply(engine, id, chrono::steady_clock::now() + chrono::milliseconds(timeout));
+        istringstream words(reply);
+        string replyId, kind, move;
+        words >> replyId >> kind >> move;
+        vector<vector<int>> newBoard;
+        if(kind == "bestmove"){
+            newBoard = findMove(board, move);
+        }
+        if(newBoard.empty()){
+            if(reply.empty()){
+                engines[engine].send(id + " stop");
+            }
+            result = {(side == 0) ? -1 : 1, reply.empty() ? "timeout" : (kind == "bestmove") ? "illegal move " + move : "error", ply};
+            break;
+        }
+        for(EngineProcess& other : engines){
+            other.send(id + " move " + move);
+        }
+        history.push_back(key);
+        board = newBoard;
+    }
+
+    for(EngineProcess& engine : engines){
+        engine.send(id + " quit");
+    }
+    lock_guard<mutex> guard(mailbox.lock);
+    mailbox.replies.erase({0, id});
+    mailbox.replies.erase({1, id});
+    return result;
+}
+
+/**
+ * Plays random moves from the starting position, again from the start if they end the game.
+ */
+vector<vector<int>> randomOpening(mt19937_64& generator){
+    vector<vector<int>> board = startingBoard;
+    for(int ply = 0; ply < RANDOM_PLIES; ply++){
+        vector<vector<vector<int>>> moveList = generateMoves(board);
+        if(moveList.empty()){
+            board = startingBoard;
+            ply = -1;
+            continue;
+        }
+        board = moveList[generator() % moveList.size()];
+    }
+    if(!hasLegalMove(board)){
+        return randomOpening(generator);
+    }
+    return board;
+}
+
+/**
+ * Elo difference of a score between 0 and 1.
+ */
+double scoreToElo(double score){
+    score = max(1e-6, min(1 - 1e-6, score));
+    return -400 * log10(1 / score - 1);
+}
+
+/**
+ * Score expected against an opponent that is elo weaker.
+ */
+double eloToScore(double elo){
+    return 1 / (1 + pow(10, -elo / 400));
+}
+
+int main(int argc, char* argv[]){
+
+    if(argc < 6 || (string(argv[4]) != "movetime" && string(argv[4]) != "nodes")){
+        cerr << "Usage: " << argv[0] << " <engine1> <engine2> <games> movetime <ms> | nodes <count>"
+            << " [--Openings file] [--Concurrency n] [--Elo0 elo] [--Elo1 elo]" << endl;
+        return 1;
+    }
+    int games = max(0, atoi(argv[3]));
+    string limitType = argv[4];
+    uint64_t limitValue = max(1ULL, strtoull(argv[5], nullptr, 10));
+    string openingFile;
+    int concurrency = max(1u, thread::hardware_concurrency());
+    double elo0 = 0, elo1 = 5;
+    for(int i = 6; i < argc; i++){
+        string argument = argv[i];
+        if(argument.rfind("--", 0) != 0 || i + 1 >= argc){
+            cerr << "WARNING -- IGNORING ARGUMENT: " << argument << endl;
+            continue;
+        }
+        string name = argument.substr(2);
+        string value = argv[++i];
+        if(name == "Openings"){
+            openingFile = value;
+        }
+        else if(name == "Concurrency" && atoi(value.c_str()) > 0){
+            concurrency = atoi(value.c_str());
+        }
+        else if(name == "Elo0"){
+            elo0 = atof(value.c_str());
+        }
+        else if(name == "Elo1"){
+            elo1 = atof(value.c_str());
+        }
+        else {
+            cerr << "WARNING -- COULD NOT SET OPTION: " << name << endl;
+        }
+    }
+
+    //Node limits still need a time limit, or the session's default budget would cut them short
+
+    string limit;
+    int timeout;
+    if(limitType == "nodes"){
+        limit = "nodes " + to_string(limitValue) + " movetime " + to_string(NODES_TIMEOUT);
+        timeout = NODES_TIMEOUT + TIMEOUT_MARGIN;
+    }
+    else {
+        limit = "movetime " + to_string(limitValue);
+        timeout = (int)min<uint64_t>(limitValue, 1 << 30) + TIMEOUT_MARGIN;
+    }
+
+    vector<vector<vector<int>>> openings;
+    if(!openingFile.empty()){
+        ifstream file(openingFile);
+        if(!file){
+            cerr << "Could not open " << openingFile << endl;
+            return 1;
+        }
+        string line;
+        int lineNumber = 0;
+        while(getline(file, line)){
+            lineNumber++;
+            if(line.find_first_not_of(" \t\r") == string::npos){
+                continue;
+            }
+            vector<vector<int>> board = boardFromFen(line);
+            EpdRecord record;
+            if(board.empty() && parseEpd(line, record)){
+                board = record.board;
+            }
+            if(board.empty() || !hasLegalMove(board)){
+                cerr << "WARNING -- SKIPPING LINE " << lineNumber << endl;
+                continue;
+            }
+            openings.push_back(board);
+        }
+        if(openings.empty()){
+            cerr << "No openings in " << openingFile << endl;
+            return 1;
+        }
+    }
+    else {
+        mt19937_64 generator(random_device{}());
+        for(int i = 0; i < (games + 1) / 2; i++){
+            openings.push_back(randomOpening(generator));
+        }
+    }
+
+#ifndef _WIN32
+    signal(SIGPIPE, SIG_IGN);
+#endif
+    vector<thread> readers;
+    for(int i = 0; i < 2; i++){
+        if(!engines[i].start(argv[1 + i]) || !engines[i].send("3")){
+            cerr << "Could not start " << argv[1 + i] << endl;
+            return 1;
+        }
+        readers.emplace_back(readReplies, i);
+    }
+
+    //Results are counted from the first engine's side
+
+    mutex resultLock;
+    int wins = 0, draws = 0, losses = 0, played = 0;
+    string verdict;
+    atomic<int> nextGame(0);
+    atomic<bool> finished(false);
+    double lowerBound = log(SPRT_ERROR / (1 - SPRT_ERROR)), upperBound = log((1 - SPRT_ERROR) / SPRT_ERROR);
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+    auto printScore = [&](){
+        int total = wins + draws + losses;
+        double score = (wins + 0.5 * draws) / total;
+        double variance = (wins * pow(1 - score, 2) + draws * pow(0.5 - score, 2) + losses * pow(score, 2)) / total;
+        double error = 1.96 * sqrt(variance / total);
+        double elo = scoreToElo(score);
+        cout << fixed << setprecision(1) << "score " << wins << "-" << draws << "-" << losses << " (" << 100 * score << "%) elo " << elo
+            << " [" << scoreToElo(score - error) << ", " << scoreToElo(score + error) << "]";
+
+        //The log likelihood ratio of the trinomial results, approximated with a normal distribution
+
+        double llr = 0;
+        if(variance > 0){
+            double score0 = eloToScore(elo0), score1 = eloToScore(elo1);
+            llr = total * (score1 - score0) * (2 * score - score0 - score1) / (2 * variance);
+        }
+        cout << setprecision(2) << " llr " << llr << " [" << lowerBound << ", " << upperBound << "]" << endl;
+        if(verdict.empty() && llr >= upperBound){
+            verdict = "H1 accepted, engine1 is at least " + to_string((int)round(elo1)) + " elo stronger";
+        }
+        else if(verdict.empty() && llr <= lowerBound){
+            verdict = "H0 accepted, engine1 is at most " + to_string((int)round(elo0)) + " elo stronger";
+        }
+    };
+
+    vector<thread> workers;
+    for(int i = 0; i < concurrency; i++){
+        workers.emplace_back([&](){
+            int game;
+            while(!finished && (game = nextGame.fetch_add(1)) < games){
+                const vector<vector<int>>& opening = openings[game / 2 % openings.size()];
+                int players[2] = {game % 2, 1 - game % 2};
+                GameResult result = playGame(game, opening, players, limit, timeout);
+                int score = (players[0] == 0) ? result.score : -result.score;
+
+                //Games still running when the test stopped are not counted, so the verdict stays the one reached
+
+                lock_guard<mutex> guard(resultLock);
+                if(finished){
+                    break;
+                }
+                wins += (score > 0);
+                draws += (score == 0);
+                losses += (score < 0);
+                played++;
+                cout << "game " << game + 1 << "/" << games << " engine" << players[0] + 1 << " vs engine" << players[1] + 1 << " "
+                    << ((result.score > 0) ? "1-0" : (result.score < 0) ? "0-1" : "1/2-1/2") << " " << result.reason
+                    << " plies " << result.plies << endl;
+                printScore();
+                if(!verdict.empty()){
+                    finished = true;
+                }
+            }
+        });
+    }
+    for(thread& worker : workers){
+        worker.join();
+    }
+    for(int i = 0; i < 2; i++){
+        engines[i].stop();
+        readers[i].join();
+    }
+
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << "games " << played << " in " << fixed << setprecision(1) << seconds << "s, concurrency " << concurrency << endl;
+    if(played){
+        printScore();
+    }
+    cout << (verdict.empty() ? "no verdict" : verdict) << endl;
+    return 0;
+}
@@ -0,0 +1,58 @@
+/**
+ * @brief Checks that every promotion survives the trip through its coordinate name
+ *
+ * For both colours, with and without a capture, every promotion is named with `moveName` and
+ * found again with `findMove`, which is how the server, the match runner and the Python module
+ * read moves. The name has to end in the letter of the piece (e7e8q for a queen) and the move
+ * found has to put that piece on the board.
+ *
+ * Usage: `moveTest.exe`
+ *
+ * It is meant to be compiled like genMove.cpp, with every file that has no main function.
+ *
+ * @author Anshuman Routray
+ */
+
+#include <cstdio>
+#include <iostream>
+#include "board.hpp"
+#include "notation.hpp"
+
+using namespace std;
+
+struct PromotionTest {
+    string fen;
+    string move;    // without the promotion letter
+    int row;        // where the promoted piece lands
+    int column;
+};
+
+const PromotionTest PROMOTION_TESTS[] = {
+    {"1r5k/P7/8/8/8/8/8/7K w - - 0 1", "a7a8", 0, 0},
+    {"1r5k/P7/8/8/8/8/8/7K w - - 0 1", "a7b8", 0, 1},
+    {"7k/8/8/8/8/8/p7/1R5K b - - 0 1", "a2a1", 7, 0},
+    {"7k/8/8/8/8/8/p7/1R5K b - - 0 1", "a2b1", 7, 1},
+};
+
+int main(){
+
+    const string LETTERS = "nbrq";
+    const int PIECES[] = {knight, bishop, rook, queen};
+
+    int failures = 0;
+    for(const PromotionTest& test : PROMOTION_TESTS){
+        vector<vector<int>> board = boardFromFen(test.fen);
+        int player = board[8][2];
+        for(size_t i = 0; i < LETTERS.size(); i++){
+            string name = test.move + LETTERS[i];
+            vector<vector<int>> newBoard = findMove(board, name);
+            string back = newBoard.empty() ? "" : moveToString(board, newBoard);
+            bool passed = !newBoard.empty() && back == name && newBoard[test.row][test.column] == player * PIECES[i];
+            printf("%-6s %-6s %s\n", name.c_str(), back.c_str(), passed ? "ok" : "FAILED");
+            failures += !passed;
+        }
+    }
+
+    cout << failures << " failed" << endl;
+    return failures ? 1 : 0;
+}
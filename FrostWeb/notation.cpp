@@ -0,0 +1,397 @@
+/**
+ * @file notation.cpp
+ * @brief Implementation of the text and binary position formats.
+ *
+ * @author Anshuman Routray
+ */
+
+#include "notation.hpp"
+#include "attacks.hpp"
+#include <cctype>
+#include <cstring>
+#include <sstream>
+
+using namespace std;
+
+static const string fenPieces = "pnbrqk";
+
+vector<vector<int>> boardFromFen(const string& fen, int* fullMoves){
+    istringstream input(fen);
+    string placement, player, castling = "-", enPassant = "-";
+    int halfMoves = 0, moveNumber = 1;
+    if(!(input >> placement >> player)){
+        return {};
+    }
+    input >> castling >> enPassant;
+    if(!(input >> halfMoves >> moveNumber)){
+        halfMoves = max(halfMoves, 0);
+        moveNumber = 1;
+    }
+    if(fullMoves){
+        *fullMoves = max(moveNumber, 1);
+    }
+
+    vector<vector<int>> board(9, vector<int>(8, space));
+    int row = 0, column = 0, kings[2] = {0, 0};
+    for(char symbol : placement){
+        if(symbol == '/'){
+            if(column != 8){
+                return {};
+            }
+            row++;
+            column = 0;
+        }
+        else if(symbol >= '1' && symbol <= '8'){
+            column += symbol - '0';
+        }
+        else {
+            size_t piece = fenPieces.find((char)tolower(symbol));
+            if(piece == string::npos || row > 7 || column > 7){
+                return {};
+            }
+            int color = isupper(symbol) ? whitePlayer : blackPlayer;
+            board[row][column++] = color * (int)(piece + 1);
+            if(piece + 1 == (size_t)king){
+                kings[color == whitePlayer]++;
+            }
+        }
+        if(column > 8){
+            return {};
+        }
+    }
+    if(row != 7 || column != 8 || kings[0] != 1 || kings[1] != 1 || (player != "w" && player != "b")){
+        return {};
+    }
+
+    //Castling rights become FrostWeb's castling states
+
+    auto castlingState = [&castling](char shortSide, char longSide){
+        bool canShort = castling.find(shortSide) != string::npos;
+        bool canLong = castling.find(longSide) != string::npos;
+        if(canShort && canLong){
+            return bothCastlingEnabled;
+        }
+        if(canShort){
+            return longCastlingDisabled;
+        }
+        if(canLong){
+            return shortCastlingDisabled;
+        }
+        return bothCastlingDisabled;
+    };
+    int playerToMove = (player == "w") ? whitePlayer : blackPlayer;
+    board[8] = {castlingState('k', 'q'), castlingState('K', 'Q'), playerToMove, -1, -1, 0, halfMoves};
+
+    //FrostWeb remembers the pawn that moved two squares instead of the square behind it
+
+    if(enPassant != "-"){
+        if(enPassant.size() != 2 || enPassant[0] < 'a' || enPassant[0] > 'h'){
+            return {};
+        }
+        int targetRow = '8' - enPassant[1];
+        int pawnRow = targetRow + playerToMove;
+        if(targetRow != (playerToMove == whitePlayer ? 2 : 5) || board[pawnRow][enPassant[0] - 'a'] != -playerToMove * pawn){
+            return {};
+        }
+        board[8][3] = pawnRow;
+        board[8][4] = enPassant[0] - 'a';
+        board[8][5] = 1;
+    }
+    return board;
+}
+
+string boardToFen(const vector<vector<int>>& board, int fullMoves){
+    string fen;
+    for(int row = 0; row < 8; row++){
+        int empty = 0;
+        for(int column = 0; column < 8; column++){
+            int piece = board[row][column];
+            if(piece == space){
+                empty++;
+                continue;
+            }
+            if(empty){
+                fen += (char)('0' + empty);
+                empty = 0;
+            }
+            char symbol = fenPieces[abs(piece) - 1];
+            fen += (piece > 0) ? (char)toupper(symbol) : symbol;
+        }
+        if(empty){
+            fen += (char)('0' + empty);
+        }
+        if(row < 7){
+            fen += '/';
+        }
+    }
+    int player = board[8][2];
+    fen += (player == whitePlayer) ? " w " : " b ";
+
+    string castling;
+    int white = board[8][1], black = board[8][0];
+    if(white == bothCastlingEnabled || white == longCastlingDisabled){
+        castling += 'K';
+    }
+    if(white == bothCastlingEnabled || white == shortCastlingDisabled){
+        castling += 'Q';
+    }
+    if(black == bothCastlingEnabled || black == longCastlingDisabled){
+        castling += 'k';
+    }
+    if(black == bothCastlingEnabled || black == shortCastlingDisabled){
+        castling += 'q';
+    }
+    fen += castling.empty() ? "-" : castling;
+
+    if(board[8][5] == 1){
+        fen += ' ';
+        fen += (char)('a' + board[8][4]);
+        fen += (char)('8' - (board[8][3] - player));
+    }
+    else {
+        fen += " -";
+    }
+    fen += " " + to_string(board[8].size() > 6 ? board[8][6] : 0) + " " + to_string(fullMoves);
+    return fen;
+}
+
+string moveToSan(const vector<vector<int>>& board, const vector<vector<int>>& newBoard){
+    int move = encodeMove(board, newBoard);
+    int from = move & 63, to = (move >> 6) & 63, promotion = move >> 12;
+    int piece = abs(board[from / 8][from % 8]);
+    string san;
+    if(piece == king && abs(from % 8 - to % 8) == 2){
+        san = (to % 8 == 6) ? "O-O" : "O-O-O";
+    }
+    else {
+        bool capture = board[to / 8][to % 8] != space || (piece == pawn && from % 8 != to % 8);
+        if(piece == pawn){
+            if(capture){
+                san += (char)('a' + from % 8);
+            }
+        }
+        else {
+            san += (char)toupper(fenPieces[piece - 1]);
+
+            //Another piece of the same kind reaching the same square needs the file, rank or both
+
+            bool sameFile = false, sameRank = false, ambiguous = false;
+            for(const vector<vector<int>>& otherBoard : generateMoves(board)){
+                int other = encodeMove(board, otherBoard);
+                int otherFrom = other & 63;
+                if(otherFrom != from && ((other >> 6) & 63) == to && abs(board[otherFrom / 8][otherFrom % 8]) == piece){
+                    ambiguous = true;
+                    sameFile |= otherFrom % 8 == from % 8;
+                    sameRank |= otherFrom / 8 == from / 8;
+                }
+            }
+            if(ambiguous && (!sameFile || sameRank)){
+                san += (char)('a' + from % 8);
+            }
+            if(ambiguous && sameFile){
+                san += (char)('8' - from / 8);
+            }
+        }
+        if(capture){
+            san += 'x';
+        }
+        san += (char)('a' + to % 8);
+        san += (char)('8' - to / 8);
+        if(promotion){
+            san += '=';
+            san += (char)toupper(fenPieces[promotion - 1]);
+        }
+    }
+    if(isInCheck(newBoard)){
+        san += generateMoves(newBoard).empty() ? '#' : '+';
+    }
+    return san;
+}
+
+vector<vector<int>> findSanMove(const vector<vector<int>>& board, const string& san){
+    string text = san;
+    while(!text.empty() && string("+#!?").find(text.back()) != string::npos){
+        text.pop_back();
+    }
+    vector<vector<vector<int>>> moveList = generateMoves(board);
+    if(text == "O-O" || text == "0-0" || text == "O-O-O" || text == "0-0-0"){
+        int column = (text.size() == 3) ? 6 : 2;
+        for(const vector<vector<int>>& newBoard : moveList){
+            int move = encodeMove(board, newBoard);
+            int from = move & 63, to = (move >> 6) & 63;
+            if(abs(board[from / 8][from % 8]) == king && abs(from % 8 - to % 8) == 2 && to % 8 == column){
+                return newBoard;
+            }
+        }
+        return {};
+    }
+
+    //Splitting the move into piece, disambiguation, target square and promotion
+
+    int piece = pawn, promotion = 0;
+    if(!text.empty() && string("NBRQK").find(text[0]) != string::npos){
+        piece = (int)fenPieces.find((char)tolower(text[0])) + 1;
+        text.erase(0, 1);
+    }
+    size_t equals = text.find('=');
+    if(equals != string::npos || (!text.empty() && string("NBRQ").find(text.back()) != string::npos)){
+        size_t position = (equals != string::npos) ? equals + 1 : text.size() - 1;
+        if(position >= text.size() || string("NBRQ").find(text[position]) == string::npos){
+            return {};
+        }
+        promotion = (int)fenPieces.find((char)tolower(text[position])) + 1;
+        text.erase((equals != string::npos) ? equals : position);
+    }
+    if(text.size() < 2){
+        return findMove(board, san);
+    }
+    int toColumn = text[text.size() - 2] - 'a', toRow = '8' - text.back();
+    string hint;
+    for(char symbol : text.substr(0, text.size() - 2)){
+        if(symbol != 'x' && symbol != '-'){
+            hint += symbol;
+        }
+    }
+    if(toColumn < 0 || toColumn > 7 || toRow < 0 || toRow > 7){
+        return findMove(board, san);
+    }
+
+    vector<vector<int>> found;
+    for(const vector<vector<int>>& newBoard : moveList){
+        int move = encodeMove(board, newBoard);
+        int from = move & 63;
+        if(((move >> 6) & 63) != toRow * 8 + toColumn || abs(board[from / 8][from % 8]) != piece || (move >> 12) != promotion){
+            continue;
+        }
+        bool matches = true;
+        for(char symbol : hint){
+            matches &= (symbol >= 'a' && symbol <= 'h') ? (from % 8 == symbol - 'a') : (from / 8 == '8' - symbol);
+        }
+        if(matches){
+            if(!found.empty()){
+                return {};
+            }
+            found = newBoard;
+        }
+    }
+
+    //Some files write moves in coordinate notation instead
+
+    return found.empty() ? findMove(board, san) : found;
+}
+
+string EpdRecord::operation(const string& opcode) const {
+    for(const pair<string, string>& operation : operations){
+        if(operation.first == opcode){
+            return operation.second;
+        }
+    }
+    return "";
+}
+
+bool parseEpd(const string& line, EpdRecord& record){
+    istringstream input(line);
+    string fields[4];
+    for(string& field : fields){
+        if(!(input >> field)){
+            return false;
+        }
+    }
+    record.board = boardFromFen(fields[0] + " " + fields[1] + " " + fields[2] + " " + fields[3]);
+    if(record.board.empty()){
+        return false;
+    }
+
+    //Operations end with a semicolon, which can also appear inside a quoted string
+
+    record.operations.clear();
+    string rest, operation;
+    getline(input, rest);
+    bool quoted = false;
+    for(char symbol : rest + ";"){
+        if(symbol == '"'){
+            quoted = !quoted;
+            continue;
+        }
+        if(symbol != ';' || quoted){
+            operation += symbol;
+            continue;
+        }
+        istringstream words(operation);
+        string opcode, operand, word;
+        if(words >> opcode){
+            while(words >> word){
+                operand += (operand.empty() ? "" : " ") + word;
+            }
+            record.operations.push_back({opcode, operand});
+        }
+        operation.clear();
+    }
+    return true;
+}
+
+string writeEpd(const EpdRecord& record){
+
+    //EPD has no move counters, the first four fields of the FEN are the position
+
+    string fen = boardToFen(record.board);
+    for(int spaces = 0, i = 0; i < (int)fen.size(); i++){
+        if(fen[i] == ' ' && ++spaces == 4){
+            fen.resize(i);
+            break;
+        }
+    }
+    for(const pair<string, string>& operation : record.operations){
+        fen += " " + operation.first;
+        if(!operation.second.empty()){
+
+            //Moves are written bare, names and comments (id, c0 to c9) and anything with spaces are quoted
+
+            const string& opcode = operation.first;
+            bool moves = opcode == "bm" || opcode == "am" || opcode == "pv" || opcode == "pm" || opcode == "sm";
+            bool text = opcode == "id" || (opcode.size() == 2 && opcode[0] == 'c' && isdigit(opcode[1]))
+                || (!moves && operation.second.find_first_of(" ;") != string::npos);
+            fen += text ? " \"" + operation.second + "\"" : " " + operation.second;
+        }
+        fen += ";";
+    }
+    return fen;
+}
+
+bool packBoard(const vector<vector<int>>& board, PackedBoard& packed){
+    memset(&packed, 0, sizeof(packed));
+    int count = 0;
+    for(int square = 0; square < 64; square++){
+        int piece = board[square / 8][square % 8];
+        if(piece == space){
+            continue;
+        }
+        if(count == 32){
+            return false;
+        }
+        packed.occupancy |= 1ULL << square;
+        uint8_t code = (uint8_t)((piece > 0) ? piece : 8 - piece);
+        packed.pieces[count / 2] |= (count % 2) ? (uint8_t)(code << 4) : code;
+        count++;
+    }
+    packed.flags[0] = (int8_t)(board[8][1] | (board[8][0] << 2));
+    packed.flags[1] = (int8_t)(board[8][2] == whitePlayer);
+    packed.flags[2] = (int8_t)board[8][3];
+    packed.flags[3] = (int8_t)board[8][4];
+    packed.flags[4] = (int8_t)board[8][5];
+    packed.flags[5] = (int8_t)min(board[8].size() > 6 ? board[8][6] : 0, 127);
+    return true;
+}
+
+vector<vector<int>> unpackBoard(const PackedBoard& packed){
+    vector<vector<int>> board(9, vector<int>(8, space));
+    uint64_t occupancy = packed.occupancy;
+    for(int count = 0; occupancy; count++){
+        int square = popSquare(occupancy);
+        int code = (count % 2) ? (packed.pieces[count / 2] >> 4) : (packed.pieces[count / 2] & 15);
+        board[square / 8][square % 8] = (code < 8) ? code : 8 - code;
+    }
+    board[8] = {(packed.flags[0] >> 2) & 3, packed.flags[0] & 3, packed.flags[1] ? whitePlayer : blackPlayer,
+        packed.flags[2], packed.flags[3], packed.flags[4], packed.flags[5]};
+    return board;
+}
@@ -0,0 +1,142 @@
+/**
+ * @file notation.hpp
+ * @brief Declaration of the text and binary formats positions are read and written in.
+ *
+ * - FEN, the standard one line description of a position.
+ * - EPD, FEN without the move counters followed by operations such as `bm Qxf7+; id "WAC.001";`,
+ *   the format of test suites.
+ * - A packed binary format of 32 bytes per position, for tools that stream millions of
+ *   positions and should not spend their time parsing text.
+ * - Training records, a packed position with its search score and game result, as written
+ *   by selfPlay.cpp and read by tune.cpp.
+ *
+ * FrostWeb boards do not track the full move number, so FEN output takes it as a parameter.
+ *
+ * @author Anshuman Routray
+ */
+
+#ifndef NOTATION_HPP
+#define NOTATION_HPP
+
+#include "board.hpp"
+#include <cstdint>
+#include <string>
+#include <utility>
+
+using namespace std;
+
+/**
+ * @brief A position packed into 32 bytes.
+ *
+ * `occupancy` has bit (row * 8 + column) set for every occupied square. The pieces of those squares
+ * follow in square order, two to a byte (low nibble first): 1 to 6 for white pawn to king, 9 to 14
+ * for black pawn to king. Two kings and at most 30 other pieces fit.
+ *
+ * `flags` holds the metadata row: castling states (white in bits 0-1, black in bits 2-3), the player to
+ * move (1 for white), the row and column of the last move (-1 if unknown), the double pawn move flag,
+ * the half move clock and two bytes free for the tool writing the position (full move number, result, ...).
+ */
+struct PackedBoard {
+    uint64_t occupancy;
+    uint8_t pieces[16];
+    int8_t flags[8];
+};
+
+static_assert(sizeof(PackedBoard) == 32, "a packed board is 32 bytes");
+
+/**
+ * @brief A position labelled for training, written to files as its 40 bytes (little-endian).
+ *
+ * Records of one game are written together and share their game number, so a data set can be
+ * split into training and validation games without positions of a game ending up on both sides.
+ */
+struct TrainingRecord {
+    PackedBoard board;
+    int16_t score;      // the search score in centipawns from white's point of view, mates at +-32000
+    int8_t result;      // 1 if white won the game, 0 for a draw, -1 if black won
+    uint8_t ply;        // number of moves played before the position, at most 255
+    uint32_t game;      // number of the game the position was played in
+};
+
+static_assert(sizeof(TrainingRecord) == 40, "a training record is 40 bytes");
+
+/**
+ * @brief Reads a FEN (or the first four fields of an EPD line).
+ *
+ * @param fen: The FEN, the half move clock and full move number may be left out
+ *
+ * @param fullMoves: If not null, receives the full move number (1 if left out)
+ *
+ * @return The board, or an empty board if the FEN is not valid.
+ */
+vector<vector<int>> boardFromFen(const string& fen, int* fullMoves = nullptr);
+
+/**
+ * @brief Writes a board as FEN.
+ *
+ * @param board: The chessboard
+ *
+ * @param fullMoves: The full move number to write, FrostWeb boards do not keep it
+ *
+ * @return The FEN of the board.
+ */
+string boardToFen(const vector<vector<int>>& board, int fullMoves = 1);
+
+/**
+ * @brief Writes a move in standard algebraic notation (Nf3, exd5, O-O, e8=Q+).
+ *
+ * @param board: The board before the move
+ *
+ * @param newBoard: The board after the move, one of `generateMoves(board)`
+ */
+string moveToSan(const vector<vector<int>>& board, const vector<vector<int>>& newBoard);
+
+/**
+ * @brief Finds the legal move written in standard algebraic or coordinate notation.
+ *
+ * Check marks and annotations (+, #, !, ?) are ignored, and so is needless disambiguation (Ngf3).
+ *
+ * @return The board after the move, or an empty board if no legal move or more than one matches.
+ */
+vector<vector<int>> findSanMove(const vector<vector<int>>& board, const string& san);
+
+/**
+ * @brief One line of an EPD file: a position and its operations in the order they appear.
+ *
+ * Operands keep their text, without the quotes around strings, so `bm Nf3 Nc3;` gives ("bm", "Nf3 Nc3").
+ */
+struct EpdRecord {
+    vector<vector<int>> board;
+    vector<pair<string, string>> operations;
+
+    /**
+     * @brief Returns the operand of an operation, or an empty string if the line does not have it.
+     */
+    string operation(const string& opcode) const;
+};
+
+/**
+ * @brief Reads one line of an EPD file.
+ *
+ * @return False if the position is not valid.
+ */
+bool parseEpd(const string& line, EpdRecord& record);
+
+/**
+ * @brief Writes a position and its operations as one line of EPD.
+ */
+string writeEpd(const EpdRecord& record);
+
+/**
+ * @brief Packs a board into 32 bytes.
+ *
+ * @return False if the board has more pieces than fit (never in a legal game).
+ */
+bool packBoard(const vector<vector<int>>& board, PackedBoard& packed);
+
+/**
+ * @brief Unpacks a board packed by `packBoard`.
+ */
+vector<vector<int>> unpackBoard(const PackedBoard& packed);
+
+#endif
@@ -0,0 +1,91 @@
+/**
+ * @file options.cpp
+ * @brief Implementation of the engine options.
+ * 
+ * @author Anshuman Routray
+ */
+
+#include "options.hpp"
+#include "book.hpp"
+#include "search.hpp"
+#include "tablebase.hpp"
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+
+using namespace std;
+
+int threadCount = max(1u, thread::hardware_concurrency());
+string skillLevel;
+int multiPVCount = 1;
+
+bool setOption(const string& name, const string& value){
+    if(name == "TTFile"){
+        if(value.empty()){
+            savedPositions.detachFile();
+            return true;
+        }
+        return savedPositions.attachFile(value);
+    }
+    if(name == "BookFile"){
+        if(value.empty()){
+            openingBook.close();
+            return true;
+        }
+        return openingBook.open(value);
+    }
+    if(name == "SyzygyPath"){
+        if(value.empty()){
+            tablebases.close();
+            return true;
+        }
+        return tablebases.open(value);
+    }
+    if(name == "BookKeys"){
+        return loadPolyglotKeys(value);
+    }
+    if(name == "Threads"){
+        int count = atoi(value.c_str());
+        if(count < 1){
+            return false;
+        }
+        threadCount = count;
+        return true;
+    }
+    if(name == "MultiPV"){
+        int count = atoi(value.c_str());
+        if(count < 1){
+            return false;
+        }
+        multiPVCount = count;
+        return true;
+    }
+    if(name == "Skill"){
+        SearchLimits limits;
+        if(!applySkillLevel(value, limits)){
+            return false;
+        }
+        skillLevel = value;
+        return true;
+    }
+    return false;
+}
+
+bool parseOptions(int argc, char* argv[]){
+    bool applied = true;
+    for(int i = 1; i < argc; i++){
+        string argument = argv[i];
+        if(argument.rfind("--", 0) != 0 || i + 1 >= argc){
+            cerr << "WARNING -- IGNORING ARGUMENT: " << argument << endl;
+            applied = false;
+            continue;
+        }
+        string name = argument.substr(2);
+        string value = argv[++i];
+        if(!setOption(name, value)){
+            cerr << "WARNING -- COULD NOT SET OPTION: " << name << endl;
+            applied = false;
+        }
+    }
+    return applied;
+}
@@ -0,0 +1,50 @@
+/**
+ * @file options.hpp
+ * @brief Declaration of the engine options.
+ * 
+ * Options can be given on the command line as `--Name value` pairs.
+ * 
+ * Supported options:
+ * - TTFile: Keeps the transposition table in the given file between runs.
+ * - Threads: Number of searches the server runs at the same time.
+ * - Skill: Plays at a named strength level with a fixed node budget instead of a fixed depth.
+ * - MultiPV: Number of best lines the search reports, each starting with a different move.
+ * - BookFile: Plays the moves of this Polyglot opening book while the position is in it.
+ * - BookKeys: Text file with all 781 Polyglot random numbers, replacing the built-in ones, which miss some (see book.hpp).
+ *   Only accepted before the first key is computed, which the first book probe does.
+ * - SyzygyPath: Directories with Syzygy endgame tables, separated by ':' (';' on Windows). The search
+ *   scores positions in the WDL tables and plays root moves from the DTZ tables. Empty closes them.
+ * 
+ * @author Anshuman Routray
+ */
+
+#ifndef OPTIONS_HPP
+#define OPTIONS_HPP
+
+#include <string>
+
+using namespace std;
+
+extern int threadCount;
+extern string skillLevel;
+extern int multiPVCount;
+
+/**
+ * @brief Sets an engine option.
+ * 
+ * @param name: The name of the option
+ * 
+ * @param value: The new value of the option
+ * 
+ * @return True if the option exists and was applied, otherwise false.
+ */
+bool setOption(const string& name, const string& value);
+
+/**
+ * @brief Applies every `--Name value` pair of the command line.
+ * 
+ * @return False if any of the options could not be applied.
+ */
+bool parseOptions(int argc, char* argv[]);
+
+#endif
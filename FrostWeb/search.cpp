@@ -20,74 +20,234 @@
  */
 
 #include "search.hpp"
+#include "book.hpp"
+#include "tablebase.hpp"
+#include "zobrist.hpp"
 #include <iostream>
 
-using Chessboard = std::vector<int>;
+//Keys of every position between the root and the current node, one stack per searching thread
 
-// Hash function for vector<int>
-struct VectorHash {
-    std::size_t operator()(const std::vector<int>& v) const {
-        std::size_t hash = 0;
-        for (int piece : v) {
-            hash ^= std::hash<int>()(piece) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
-        }
-        return hash;
+thread_local vector<uint64_t> keyHistory;
+
+//Node count and limits of the search running on this thread
+
+struct SearchState {
+    uint64_t nodes = 0;
+    uint64_t nodeLimit = UINT64_MAX;
+    chrono::steady_clock::time_point deadline = chrono::steady_clock::time_point::max();
+    chrono::steady_clock::time_point started;
+    const atomic<bool>* stop = nullptr;
+    const atomic<bool>* ponder = nullptr;
+    double noise = 0.0;
+    uint64_t nextClockRead = 0;
+    uint64_t nextStopRead = 0;
+    bool limitsActive = false;  // off until the first iteration is finished, so every root move has a result
+    size_t rootMoves = 0;       // root moves with a result in the current iteration
+    bool pondering = false;
+    bool aborted = false;
+    TranspositionTable* table = &savedPositions;
+};
+
+thread_local SearchState searchState;
+
+//Triangular principal variation table: row `ply` holds the best line found from that ply on, in
+//columns ply to pvLength[ply] - 1, built from the row below whenever a move improves the position
+
+thread_local vector<vector<int>> pvTable(maxPly + 2, vector<int>(maxPly + 2, noMove));
+thread_local vector<int> pvLength(maxPly + 2, 0);
+
+/**
+ * The function `updatePV` makes `move` followed by the best line of the next ply the best line at `ply`.
+ */
+static void updatePV(int ply, int move){
+    vector<int>& line = pvTable[ply];
+    const vector<int>& childLine = pvTable[ply + 1];
+    line[ply] = move;
+    for(int i = ply + 1; i < pvLength[ply + 1]; i++){
+        line[i] = childLine[i];
     }
+    pvLength[ply] = max(pvLength[ply + 1], ply + 1);
+}
+
+//Reading the clock costs more than a node, so it is only read every this many nodes
+
+static const uint64_t clockInterval = 64;
+
+//The stop flag is cheaper to read, a node takes tens of microseconds so this answers a stop well within a millisecond
+
+static const uint64_t stopInterval = 8;
+
+//Strength levels, weaker levels search fewer nodes and misjudge positions by up to `noise` pawns
+
+struct SkillLevel {
+    const char* name;
+    uint64_t nodes;
+    double noise;
 };
 
-unordered_map<Chessboard, double, VectorHash> savedPositions;
+static const SkillLevel skillLevels[] = {
+    {"beginner", 300, 1.5},
+    {"novice", 1000, 0.8},
+    {"casual", 3000, 0.4},
+    {"club", 10000, 0.15},
+    {"expert", 40000, 0.05},
+    {"master", 100000, 0.0}
+};
+
+bool applySkillLevel(const string& name, SearchLimits& limits){
+    for(const SkillLevel& level : skillLevels){
+        if(name == level.name){
+            limits.nodes = level.nodes;
+            limits.noise = level.noise;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * The function `endPonder` turns a ponder search into a normal one once the opponent played the
+ * expected move. The time and nodes spent pondering were free, so the limits count from now.
+ */
+static void endPonder(){
+    searchState.pondering = false;
+    if(searchState.deadline != chrono::steady_clock::time_point::max()){
+        searchState.deadline += chrono::steady_clock::now() - searchState.started;
+    }
+    if(searchState.nodeLimit != UINT64_MAX){
+        searchState.nodeLimit += searchState.nodes;
+    }
+}
 
 /**
- * The function `getValue` retrieves the value associated with a key in an unordered map, returning a
- * default value if the key is not found.
+ * The function `outOfLimits` checks if the search has to stop, called once per node.
  * 
- * @param myMap An unordered map that stores values of type double associated with keys of type
- * Chessboard. The keys are hashed using a custom hash function VectorHash.
- * @param key The `key` parameter is of type `Chessboard`, which is used to look up a value in the
- * `myMap` unordered map.
- * 
- * @return If the key is found in the `myMap`, the associated value is being returned. Otherwise, the
- * default value of -3141.0 is being returned.
+ * @return True if the search was stopped or has run out of time or nodes, otherwise false.
  */
-double getValue(const std::unordered_map<Chessboard, double, VectorHash>& myMap, const Chessboard& key) {
-    auto it = myMap.find(key);
-    if (it != myMap.end()) {
-        return it->second; // Return the associated value
+static bool outOfLimits(){
+
+    //Quiescence nodes are counted between the calls, so the count is compared with the next read instead of taken modulo
+
+    bool readClock = searchState.nodes >= searchState.nextClockRead;
+    if(readClock){
+        searchState.nextClockRead = searchState.nodes + clockInterval;
+    }
+    if(searchState.pondering && readClock && !searchState.ponder->load(memory_order_relaxed)){
+        endPonder();
+    }
+    if(searchState.nodes >= searchState.nextStopRead){
+        searchState.nextStopRead = searchState.nodes + stopInterval;
+        if(searchState.stop && searchState.stop->load(memory_order_relaxed)){
+            return true;
+        }
+    }
+
+    //Only the node and time limits wait for the first iteration, and a ponder search runs until the opponent moves
+
+    if(!searchState.limitsActive || searchState.pondering){
+        return false;
     }
-    return -3141.0; // Return default value if key not found
+    return searchState.nodes > searchState.nodeLimit || (readClock && chrono::steady_clock::now() >= searchState.deadline);
 }
 
+/**
+ * The function `evaluationNoise` returns the error a weakened search makes when it evaluates a position.
+ * 
+ * It only depends on the position, so a position is misjudged the same way every time it is reached
+ * and the search stays deterministic.
+ * 
+ * @param key The Zobrist key of the position.
+ * @param noise The largest possible error in pawns.
+ * 
+ * @return An error between -noise and noise.
+ */
+static double evaluationNoise(uint64_t key, double noise){
+    uint64_t z = key + 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    z ^= z >> 31;
+    return noise * ((double)(z >> 11) / (double)(1ULL << 53) * 2.0 - 1.0);
+}
 
 /**
- * The function `createChessBoard` converts a 2D vector representing a chessboard into a 1D vector.
+ * The function `isRepetition` checks if a position already occurred earlier on the current line.
+ * 
+ * Only positions with the same player to move and no capture or pawn move in between can be
+ * identical, so the scan steps back two plies at a time and stops at the half move clock.
  * 
- * @param board The `board` parameter is a 2D vector representing a chessboard with dimensions 8x8.
- * Each element in the vector represents a square on the chessboard and contains an integer value. The
- * function `createChessBoard` takes this 2D vector and converts it into a 1
+ * @param key The Zobrist key of the current position.
+ * @param halfMoves The half move clock of the current position.
  * 
- * @return The function `createChessBoard` returns a `Chessboard` object, which is created by iterating
- * over a 2D vector `board` and pushing its elements into the `newBoard` vector.
+ * @return True if the position is a repetition, otherwise false.
  */
-Chessboard createChessBoard(vector<vector<int>> board){
-    Chessboard newBoard;
-    newBoard.reserve(64);
-    for(int i = 0; i < 8; i++){
-        for(int j = 0; j < 8; j++){
-            newBoard.push_back(board[i][j]);
+bool isRepetition(uint64_t key, int halfMoves){
+    int size = keyHistory.size();
+    for(int i = size - 2; i >= 0 && size - i <= halfMoves; i -= 2){
+        if(keyHistory[i] == key){
+            return true;
         }
     }
-    return newBoard;
+    return false;
+}
+
+//Score of being checkmated at the root, every ply until the mate takes one off
+
+const double mateValue = 500.0;
+const int maxPly = 128;
+
+bool isMateScore(double evaluation){
+    return abs(evaluation) >= mateValue - maxPly;
+}
+
+/**
+ * The function `scoreToTable` converts a mate score from distance to the root into distance
+ * to the current position, so the stored score stays valid wherever the position is reached again.
+ * 
+ * @param evaluation The evaluation returned by the search.
+ * @param ply The distance of the current position from the root.
+ * 
+ * @return The evaluation to store in the transposition table.
+ */
+double scoreToTable(double evaluation, int ply){
+    if(evaluation >= mateValue - maxPly){
+        return evaluation + ply;
+    }
+    if(evaluation <= -(mateValue - maxPly)){
+        return evaluation - ply;
+    }
+    return evaluation;
+}
+
+/**
+ * The function `scoreFromTable` undoes `scoreToTable`, turning a stored mate score back into
+ * distance from the root of the current search.
+ * 
+ * @param evaluation The evaluation read from the transposition table.
+ * @param ply The distance of the current position from the root.
+ * 
+ * @return The evaluation as seen from the root.
+ */
+double scoreFromTable(double evaluation, int ply){
+    if(evaluation >= mateValue - maxPly){
+        return evaluation - ply;
+    }
+    if(evaluation <= -(mateValue - maxPly)){
+        return evaluation + ply;
+    }
+    return evaluation;
 }
 
 double stable_search(vector<vector<int>> board){
     int player = board[8][2];
     int pos1 = board[8][3];
     int pos2 = board[8][4];
-    board[8][2] = -player;
-    if(!isAttacked(board, {pos1, pos2})){
-        return evaluate(board);      
+
+    //The position is stable once the piece that moved last is no longer attacked
+
+    uint64_t lastMoved = (pos1 >= 0) ? (1ULL << (pos1 * 8 + pos2)) : 0;
+    if(!(attackInfo(board).attacked[player == whitePlayer] & lastMoved)){
+        return cachedEvaluate(board);
     }
-    board[8][2] = player; 
     vector<vector<vector<int>>> moveList = generateMoves(board);
     int minValue = 1000;
     vector<vector<int>> nextBoard; 
@@ -97,64 +257,119 @@ double stable_search(vector<vector<int>> board){
             nextBoard = newBoard;
         }
     }
+
+    //Only pinned pieces attack the square, so there is no capture to play
+
     if(nextBoard.empty()){
-        cerr << "WARNING -- UNEXPECTED BEHAVIOR: NEXT BOARD IS EMPTY" << endl;
-        cerr << moveList.size() << endl;
-        for(int i = 0; i < 8; i++){
-            for(int j = 0; j < 8; j++){
-                std::cout << board[i][j] << "  ";
-            }
-            std::cout << endl;
-        }
-        std::cout << board[8][0] << " " << board[8][1] << " " << board[8][2] << " " << board[8][3] 
-            << " " << board[8][4] << " " << board[8][5];
-        
-        std::cout << endl << endl;
+        return cachedEvaluate(board);
     }
-    nextBoard[8][2] = -nextBoard[8][2];
-    if(pieceValues[abs(board[pos1][pos2])] < minValue && isAttacked(nextBoard, {pos1, pos2})){
-        return evaluate(board);
+
+    //Stopping if the capturing piece is worth more than the captured one and can be taken back
+
+    if(pieceValues[abs(board[pos1][pos2])] < minValue &&
+        (attackInfo(nextBoard).attacked[nextBoard[8][2] == whitePlayer] & lastMoved)){
+        return cachedEvaluate(board);
     }
-    nextBoard[8][2] = -nextBoard[8][2];
+
+    //Every capture is a node of its own and counts against the node limit
+
+    ++searchState.nodes;
     double evaluation = stable_search(nextBoard);
     return evaluation;
 }
 
-double search(vector<vector<int>> board, int depth, double bestOfWhite, double bestOfBlack){
+double search(vector<vector<int>> board, int depth, double bestOfWhite, double bestOfBlack, int ply){
     int player = board[8][2];
+    pvLength[ply] = ply;
+
+    //Once the deadline has passed every node returns at once, the caller throws the result away
+
+    if(searchState.aborted){
+        return 0.0;
+    }
+    ++searchState.nodes;
+    if(outOfLimits()){
+        searchState.aborted = true;
+        return 0.0;
+    }
+
+    //Mate distance pruning: the player to move cannot mate before the next ply or be mated before this one
+
+    double whiteCeiling = mateValue - ply - ((player == whitePlayer) ? 1 : 0);
+    double blackFloor = -(mateValue - ply - ((player == blackPlayer) ? 1 : 0));
+    if(whiteCeiling <= bestOfWhite){
+        return bestOfWhite;
+    }
+    if(blackFloor >= bestOfBlack){
+        return bestOfBlack;
+    }
+
+    //A repeated position is a draw, there is no point in searching it again
+
+    uint64_t key = zobristKey(board);
+    if(isRepetition(key, board[8][6])){
+        return 0.0;
+    }
+
+    //Positions in the endgame tables are known exactly, there is nothing left to search. The tables
+    //ignore the fifty move rule, so they are only trusted right after a capture or pawn move
+
+    int tableResult;
+    if(tablebases.isOpen() && board[8][6] == 0 && tablebases.probeWDL(board, tableResult)){
+        return tablebaseScore(tableResult, player, ply);
+    }
+
     vector<vector<vector<int>>> moveList = generateMoves(board);
 
     //If no legal moves are possible
     if(moveList.size() == 0){
 
-        //Check if the king is under attack
+        //Check if the king is under attack, mates closer to the root score higher
 
-        pair<int, int> kingPos = retrieveKingPosition(board, player);
-        if(isAttacked(board, kingPos)){
-            return -player * 100.0;
+        if(isInCheck(board)){
+            return -player * (mateValue - ply);
         }
         else {
             return 0.0;
         }
     }
 
-    Chessboard hashedBoard = createChessBoard(board);
+    //Fifty moves without a capture or pawn move (checkmate on the last move still counts)
 
-    if(getValue(savedPositions, hashedBoard) != -3141.0){
-        return savedPositions[hashedBoard];
+    if(board[8][6] >= 100){
+        return 0.0;
+    }
+
+    //A bound from the table is only good enough if it falls outside the window
+
+    double tableEvaluation;
+    int tableBound;
+    if(searchState.table->probe(key, depth, tableEvaluation, tableBound)){
+        tableEvaluation = scoreFromTable(tableEvaluation, ply);
+        if(tableBound == exactBound || (tableBound == lowerBound && tableEvaluation >= bestOfBlack)
+            || (tableBound == upperBound && tableEvaluation <= bestOfWhite)){
+            return tableEvaluation;
+        }
     }
 
     if(depth == 0){
         double evaluation = stable_search(board);
+        if(searchState.noise > 0.0){
+            evaluation += evaluationNoise(key, searchState.noise);
+        }
         return evaluation;
     }
     double evaluation = 0;
+    double windowLow = bestOfWhite, windowHigh = bestOfBlack;
+    keyHistory.push_back(key);
     if(player == whitePlayer){
         evaluation = -1000.0;
-        int count = 0;
         for(vector<vector<int>> newBoard : moveList){
-            double newEvaluation = search(newBoard, depth - 1, bestOfWhite, bestOfBlack);
-            evaluation = max(evaluation, newEvaluation);
+            double newEvaluation = search(newBoard, depth - 1, bestOfWhite, bestOfBlack, ply + 1);
+            if(newEvaluation > evaluation){
+                evaluation = newEvaluation;
+                updatePV(ply, encodeMove(board, newBoard));
+            }
             bestOfWhite = max(bestOfWhite, newEvaluation);
             if(bestOfBlack <= bestOfWhite){
                 break;
@@ -164,8 +379,11 @@ double search(vector<vector<int>> board, int depth, double bestOfWhite, double b
     else {
         evaluation = 1000.0;
         for(vector<vector<int>> newBoard : moveList){   
-            double newEvaluation = search(newBoard, depth - 1, bestOfWhite, bestOfBlack);
-            evaluation = min(evaluation, newEvaluation);
+            double newEvaluation = search(newBoard, depth - 1, bestOfWhite, bestOfBlack, ply + 1);
+            if(newEvaluation < evaluation){
+                evaluation = newEvaluation;
+                updatePV(ply, encodeMove(board, newBoard));
+            }
             bestOfBlack = min(bestOfBlack, newEvaluation);
             if(bestOfBlack <= bestOfWhite){
                 break;
@@ -173,45 +391,254 @@ double search(vector<vector<int>> board, int depth, double bestOfWhite, double b
         }
     }
 
-    savedPositions[hashedBoard] = evaluation;
+    keyHistory.pop_back();
+
+    //A result outside the window is only a bound: the real evaluation is at most (or at least) this.
+    //Noisy evaluations stay out of the table, other searches share it
+
+    if(!searchState.aborted && searchState.noise == 0.0){
+        int bound = (evaluation <= windowLow) ? upperBound : (evaluation >= windowHigh) ? lowerBound : exactBound;
+        searchState.table->store(key, depth, scoreToTable(evaluation, ply), bound);
+    }
 
     return evaluation;
 }
 
+/**
+ * The function `searchRoot` searches the root moves from index `first` on and moves the best of them to `first`.
+ * Moves are searched in order, so the moves of earlier lines are left out and the best move of the
+ * previous iteration is tried first, which makes the cutoffs come sooner.
+ * 
+ * @param board The root position.
+ * @param moveList The boards after every root move.
+ * @param first The first move to search.
+ * @param depth The depth to search at.
+ * 
+ * @return The best line starting with one of the searched moves, without moves if the search was
+ * stopped before the first move had a result.
+ */
+static PrincipalVariation searchRoot(const vector<vector<int>>& board, vector<vector<vector<int>>>& moveList, size_t first, int depth){
+    int player = board[8][2];
+    double bestOfWhite = -1000.0, bestOfBlack = 1000.0;
+    PrincipalVariation best;
+    best.evaluation = -player * 1000.0;
+    size_t bestIndex = first;
+    for(size_t i = first; i < moveList.size(); i++){
+        double evaluation = search(moveList[i], depth - 1, bestOfWhite, bestOfBlack, 1);
+
+        //The evaluation of a move whose search was stopped means nothing, the moves before it still count
+
+        if(searchState.aborted){
+            break;
+        }
+        searchState.rootMoves = max(searchState.rootMoves, i + 1);
+        if(evaluation * player > best.evaluation * player){
+            best.evaluation = evaluation;
+            best.moves.assign(1, encodeMove(board, moveList[i]));
+            best.moves.insert(best.moves.end(), pvTable[1].begin() + 1, pvTable[1].begin() + pvLength[1]);
+            bestIndex = i;
+        }
+        if(player == whitePlayer){
+            bestOfWhite = max(evaluation, bestOfWhite);
+        }
+        else {
+            bestOfBlack = min(evaluation, bestOfBlack);
+        }
+
+        //A mate in one cannot be improved on
+
+        if(evaluation * player >= mateValue - 1){
+            break;
+        }
+    }
+    rotate(moveList.begin() + first, moveList.begin() + bestIndex, moveList.begin() + bestIndex + 1);
+    return best;
+}
+
 vector<vector<int>> getBestMove(vector<vector<int>> board, int depth){
+    SearchLimits limits;
+    limits.depth = depth;
+    return searchPosition(board, limits).bestBoard;
+}
+
+SearchResult searchPosition(const vector<vector<int>>& board, const SearchLimits& limits, const vector<uint64_t>& gameHistory,
+    const function<void(const SearchResult&)>& onIteration){
+    SearchResult result;
     vector<vector<vector<int>>> moveList = generateMoves(board);
     int player = board[8][2];
     if(moveList.size() == 0){
         
         //Check if the king is under attack
 
-        pair<int, int> kingPos = retrieveKingPosition(board, player);
-        if(isAttacked(board, kingPos)){
-            return {{player}};
+        if(isInCheck(board)){
+            result.bestBoard = {{player}};
+            result.evaluation = -player * mateValue;
         }
         else {
-            return {{0}};
+            result.bestBoard = {{0}};
         } 
+        return result;
     }
-    double bestOfWhite = -1000.0, bestOfBlack = 1000.0;
-    double bestEval = (player == whitePlayer) ? -1000.0 : 1000.0;
-    vector<vector<int>> bestBoard;
-    for(vector<vector<int>> newBoard : moveList){
-        double evaluation = search(newBoard, depth - 1, bestOfWhite, bestOfBlack);
-        if(player == whitePlayer){
-            bestOfWhite = max(evaluation, bestOfWhite);
-            if(evaluation > bestEval){
-                bestEval = evaluation;
-                bestBoard = newBoard;
+
+    //A book move needs no search, unless the caller wants lines to analyse or is pondering
+
+    bool ponderStart = limits.ponder && limits.ponder->load(memory_order_relaxed);
+    if(limits.useBook && limits.multiPV == 1 && !ponderStart){
+        vector<vector<int>> bookBoard = openingBook.pickMove(board);
+        if(!bookBoard.empty()){
+            result.bestBoard = bookBoard;
+            result.lines.push_back({{encodeMove(board, bookBoard)}, 0.0});
+            result.fromBook = true;
+            return result;
+        }
+    }
+
+    //Neither does a position in the endgame tables, the DTZ tables pick the move that wins within
+    //the fifty move rule, and its line follows them
+
+    if(tablebases.isOpen() && limits.multiPV == 1 && !ponderStart){
+        int tableResult;
+        vector<vector<int>> tableBoard = tablebases.bestMove(board, tableResult);
+        if(!tableBoard.empty()){
+            PrincipalVariation line;
+            line.evaluation = tablebaseScore(tableResult, player, 0);
+            vector<vector<int>> position = board, next = tableBoard;
+            while(!next.empty() && (int)line.moves.size() < maxPly && (tableResult != tablebaseDraw || line.moves.size() < 2)){
+                line.moves.push_back(encodeMove(position, next));
+                position = next;
+                int nextResult;
+                next = tablebases.bestMove(position, nextResult);
             }
+            result.bestBoard = tableBoard;
+            result.evaluation = line.evaluation;
+            result.lines.push_back(line);
+            result.fromTablebase = true;
+            return result;
         }
-        else {
-            bestOfBlack = min(evaluation, bestOfBlack);
-            if(evaluation < bestEval){
-                bestEval = evaluation;
-                bestBoard = newBoard;
+    }
+    uint64_t rootKey = zobristKey(board);
+
+    //The node and time limits wait until the first iteration is finished, so even a search that starts
+    //after its deadline has looked at every root move once
+
+    searchState = SearchState();
+    if(limits.table){
+        searchState.table = limits.table;
+    }
+    searchState.table->newSearch();
+    searchState.nodeLimit = limits.nodes;
+    searchState.deadline = limits.deadline;
+    searchState.started = chrono::steady_clock::now();
+    searchState.stop = limits.stop;
+    searchState.ponder = limits.ponder;
+    searchState.pondering = limits.ponder && limits.ponder->load(memory_order_relaxed);
+    searchState.noise = limits.noise;
+    int lineCount = (int)min((size_t)max(limits.multiPV, 1), moveList.size());
+    for(int depth = 1; depth <= limits.depth; depth++){
+
+        //Every extra line searches the root again without the moves already reported, the
+        //table still holds most of the tree from the lines before
+
+        vector<PrincipalVariation> lines;
+        searchState.rootMoves = 0;
+        for(int line = 0; line < lineCount && !searchState.aborted; line++){
+            keyHistory = gameHistory;
+            keyHistory.push_back(rootKey);
+            lines.push_back(searchRoot(board, moveList, line, depth));
+        }
+        if(searchState.aborted){
+
+            //Stopped during the first iteration: the best root move searched so far, or the first legal one
+
+            if(result.depth == 0){
+                bool searched = !lines.empty() && !lines[0].moves.empty();
+                result.bestBoard = moveList[0];
+                result.evaluation = searched ? lines[0].evaluation : 0.0;
+                result.lines.assign(1, searched ? lines[0] : PrincipalVariation{{encodeMove(board, moveList[0])}, 0.0});
+                result.rootMoves = searchState.rootMoves;
             }
+            break;
+        }
+        result.bestBoard = moveList[0];
+        result.evaluation = lines[0].evaluation;
+        result.lines = lines;
+        result.depth = depth;
+        result.rootMoves = searchState.rootMoves;
+        result.nodes = searchState.nodes;
+        searchState.limitsActive = true;
+        if(onIteration){
+            onIteration(result);
+        }
+        if(isMateScore(result.evaluation)){
+            break;
         }
     }
-    return bestBoard;
-}
\ No newline at end of file
+
+    //A ponder search that ran out of depth waits, its move is only wanted once the opponent has moved
+
+    while(searchState.pondering && !(limits.stop && limits.stop->load(memory_order_relaxed))){
+        if(!limits.ponder->load(memory_order_relaxed)){
+            break;
+        }
+        this_thread::sleep_for(chrono::milliseconds(1));
+    }
+    result.nodes = searchState.nodes;
+    return result;
+}
+
+shared_ptr<SearchHandle> startSearch(const vector<vector<int>>& board, const SearchLimits& limits,
+    const vector<uint64_t>& gameHistory, function<void(const SearchResult&)> onFinished){
+    shared_ptr<SearchHandle> handle(new SearchHandle());
+    SearchLimits searchLimits = limits;
+    searchLimits.stop = &handle->stopFlag;
+    SearchHandle* self = handle.get();
+    handle->worker = thread([self, board, searchLimits, gameHistory, onFinished]{
+        SearchResult result = searchPosition(board, searchLimits, gameHistory, [self](const SearchResult& iteration){
+            lock_guard<mutex> guard(self->lock);
+            self->result = iteration;
+        });
+        {
+            lock_guard<mutex> guard(self->lock);
+            self->result = result;
+            self->finished = true;
+        }
+        self->done.notify_all();
+        if(onFinished){
+            onFinished(result);
+        }
+    });
+    return handle;
+}
+
+SearchHandle::~SearchHandle(){
+    stop();
+
+    //A handle released from its own completion callback cannot wait for its own thread
+
+    if(worker.get_id() == this_thread::get_id()){
+        worker.detach();
+    }
+    else if(worker.joinable()){
+        worker.join();
+    }
+}
+
+void SearchHandle::stop(){
+    stopFlag.store(true, memory_order_relaxed);
+}
+
+bool SearchHandle::isFinished() const {
+    lock_guard<mutex> guard(lock);
+    return finished;
+}
+
+SearchResult SearchHandle::bestSoFar() const {
+    lock_guard<mutex> guard(lock);
+    return result;
+}
+
+SearchResult SearchHandle::wait(){
+    unique_lock<mutex> guard(lock);
+    done.wait(guard, [this]{ return finished; });
+    return result;
+}
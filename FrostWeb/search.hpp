@@ -6,8 +6,9 @@
  * and determine optimal moves. It includes functions such as `search()`, `stable_search()`, `getBestMove()`, 
  * and `generateMoves()` that are essential for analyzing the game state and selecting moves.
  * 
- * The file also defines a custom hash function (`VectorHash`) for hashing the chessboard state and storing 
- * previously evaluated positions in an unordered map to speed up the search process.
+ * Previously evaluated positions are stored in the transposition table (`savedPositions`), keyed by
+ * their Zobrist key, to speed up the search process. The table is shared, so several threads can
+ * search at the same time.
  */
 
 #ifndef SEARCH_HPP
@@ -15,7 +16,95 @@
 
 #include "board.hpp"
 #include "evaluate.hpp"
-#include <unordered_map>
+#include "transposition.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+extern const double mateValue;
+extern const int maxPly;
+
+/**
+ * @brief How long a search may run.
+ * 
+ * The search deepens one ply at a time until it reaches `depth`, runs past `deadline` or has visited
+ * `nodes` positions, quiescence captures included, an iteration that is cut off is thrown away. The
+ * deadline and node budget are only checked once the first iteration is finished, so every search
+ * looks at each root move at least at depth 1, even one that starts after its deadline. `stop` is
+ * always checked: a search stopped during the first iteration plays the best root move searched so
+ * far, or the first legal move if none was searched yet.
+ * 
+ * A node budget costs about the same CPU time in every position, which a depth does not.
+ * 
+ * While `ponder` is set the search is pondering: it ignores its deadline and node budget and does not
+ * return before the flag is cleared (the opponent played the expected move) or the search is stopped.
+ * Once cleared the deadline and node budget count from that moment.
+ */
+struct SearchLimits {
+    int depth = maxPly;
+    chrono::steady_clock::time_point deadline = chrono::steady_clock::time_point::max();
+    uint64_t nodes = UINT64_MAX;
+    double noise = 0.0;     // largest error in pawns added to every evaluation, to play weaker
+    const atomic<bool>* stop = nullptr;     // the search ends soon after this is set
+    const atomic<bool>* ponder = nullptr;
+    int multiPV = 1;        // number of best lines to find, each with a different first move
+    bool useBook = true;    // play from the opening book when the position is in it
+    TranspositionTable* table = nullptr;    // the table to search with, savedPositions if null
+};
+
+/**
+ * @brief A line the search expects to be played, with the evaluation at its end.
+ * 
+ * Moves are packed like `encodeMove`. The line can stop early where the transposition table cut
+ * the search short.
+ */
+struct PrincipalVariation {
+    vector<int> moves;
+    double evaluation = 0.0;
+};
+
+/**
+ * @brief The outcome of `searchPosition`.
+ * 
+ * If the game is already over bestBoard is {{0}} for a stalemate or {{player}} if the player to move
+ * is checkmated, like `getBestMove`.
+ */
+struct SearchResult {
+    vector<vector<int>> bestBoard;
+    double evaluation = 0.0;
+    int depth = 0;          // depth of the last finished iteration
+    size_t rootMoves = 0;   // root moves with a result in that iteration, or before a stop during the first
+    uint64_t nodes = 0;     // positions visited by search()
+    vector<PrincipalVariation> lines;   // best line first, then the next best (with MultiPV)
+    bool fromBook = false;  // the move came from the opening book, without a search
+    bool fromTablebase = false;     // the move came from the endgame tables, without a search
+};
+
+/**
+ * @brief Sets the node budget and evaluation noise of a named strength level.
+ * 
+ * From weakest to strongest: beginner, novice, casual, club, expert, master.
+ * 
+ * @param name: The name of the level
+ * 
+ * @param limits: Receives the node budget and noise of the level
+ * 
+ * @return False if there is no level with that name.
+ */
+bool applySkillLevel(const string& name, SearchLimits& limits);
+
+/**
+ * @brief Checks if an evaluation is a forced mate score rather than a material/positional score.
+ * 
+ * @param evaluation The evaluation to check
+ * 
+ * @return True if the evaluation encodes a mate, otherwise false.
+ */
+bool isMateScore(double evaluation);
 
 /**
  * @brief The function `stable_search` recursively evaluates stable positions in a chess game to find the best
@@ -36,9 +125,11 @@ double stable_search(vector<vector<int>> board);
  * 
  * @param depth: The amount of turns into the game the function will search through
  * 
- * @return The final evaluation of the position
+ * @param ply: The distance of the board from the root of the search
+ * 
+ * @return The final evaluation of the position, checkmates score mateValue minus the ply they happen at
  */
-double search(vector<vector<int>> board, int depth, double bestOfWhite, double bestOfBlack);
+double search(vector<vector<int>> board, int depth, double bestOfWhite, double bestOfBlack, int ply);
 
 /**
  * @brief Returns the best possible move possible out of all legal moves.
@@ -54,4 +145,78 @@ double search(vector<vector<int>> board, int depth, double bestOfWhite, double b
  */
 vector<vector<int>> getBestMove(vector<vector<int>> board, int depth);
 
+/**
+ * @brief Searches a position with iterative deepening until the limits run out.
+ * 
+ * @param board: The chessboard represntation
+ * 
+ * @param limits: The depth and deadline of the search
+ * 
+ * @param gameHistory: Zobrist keys of the positions played before this one, to detect repetitions
+ * 
+ * @param onIteration: Called with the result of every iteration that finishes
+ * 
+ * @return The best move found and how it was found.
+ */
+SearchResult searchPosition(const vector<vector<int>>& board, const SearchLimits& limits, const vector<uint64_t>& gameHistory = {},
+    const function<void(const SearchResult&)>& onIteration = nullptr);
+
+/**
+ * @brief A search running on its own thread, created by `startSearch`.
+ * 
+ * Releasing the last reference stops the search and waits for its thread.
+ */
+class SearchHandle {
+public:
+    ~SearchHandle();
+
+    /**
+     * @brief Asks the search to finish, it returns the last finished iteration within about a millisecond.
+     */
+    void stop();
+
+    /**
+     * @brief Checks if the search has finished, because of its limits or `stop()`.
+     */
+    bool isFinished() const;
+
+    /**
+     * @brief Returns the result of the deepest iteration finished so far (an empty bestBoard before the first).
+     */
+    SearchResult bestSoFar() const;
+
+    /**
+     * @brief Waits for the search to finish and returns its result.
+     */
+    SearchResult wait();
+
+private:
+    friend shared_ptr<SearchHandle> startSearch(const vector<vector<int>>&, const SearchLimits&,
+        const vector<uint64_t>&, function<void(const SearchResult&)>);
+    SearchHandle() = default;
+
+    atomic<bool> stopFlag{false};
+    mutable mutex lock;
+    condition_variable done;
+    SearchResult result;
+    bool finished = false;
+    thread worker;
+};
+
+/**
+ * @brief Starts searching a position on a new thread and returns at once.
+ * 
+ * @param board: The chessboard represntation
+ * 
+ * @param limits: The depth, deadline and node budget of the search (its stop flag is replaced by the handle's)
+ * 
+ * @param gameHistory: Zobrist keys of the positions played before this one, to detect repetitions
+ * 
+ * @param onFinished: Called on the search thread with the final result
+ * 
+ * @return A handle to stop the search, read its progress and wait for it.
+ */
+shared_ptr<SearchHandle> startSearch(const vector<vector<int>>& board, const SearchLimits& limits,
+    const vector<uint64_t>& gameHistory = {}, function<void(const SearchResult&)> onFinished = nullptr);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,176 @@
+/**
+ * @brief Plays the engine against itself and writes every position as training data
+ *
+ * Every worker plays one game at a time with its own transposition table, cleared between games,
+ * searching every move with a fixed node budget, so the games cost the same on any machine and
+ * load. Each game starts
+ * with a few random moves so no two games are alike. The positions the engine searched are
+ * written as 40 byte training records (see notation.hpp) with the search score and, once the
+ * game is over, its result. Records of a game are appended together when it ends.
+ *
+ * A game ends in checkmate, stalemate, threefold repetition, the fifty move rule, after MAX_PLIES
+ * moves (a draw) or once one side has been more than RESIGN_SCORE pawns ahead for RESIGN_PLIES
+ * moves in a row (a win for that side).
+ *
+ * Usage: `selfPlay.exe <output> <games> <nodes>` followed by engine options like `--Threads 8`.
+ * The output file is appended to, so several runs can fill the same file, game numbers carry on
+ * from the last game in it.
+ *
+ * It is meant to be compiled like genMove.cpp, with every file that has no main function.
+ *
+ * @author Anshuman Routray
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include "notation.hpp"
+#include "options.hpp"
+#include "search.hpp"
+#include "zobrist.hpp"
+
+using namespace std;
+
+const int RANDOM_PLIES = 8; //Random moves at the start of every game
+const int MAX_PLIES = 300; //Moves after which a game is a draw
+const double RESIGN_SCORE = 10.0; //Pawns ahead that decide a game
+const int RESIGN_PLIES = 6; //Moves in a row the score has to stay decided
+const size_t TABLE_ENTRIES = 1 << 18; //Transposition table entries of each worker
+
+mutex outputLock;
+FILE* output;
+atomic<uint32_t> nextGame(0);
+atomic<uint64_t> positionsWritten(0);
+
+int16_t scoreToCentipawns(double evaluation){
+    if(isMateScore(evaluation)){
+        return (evaluation > 0) ? 32000 : -32000;
+    }
+    return (int16_t)max(-31999.0, min(31999.0, round(evaluation * 100)));
+}
+
+/**
+ * Plays one game and returns its positions, labelled with the result.
+ */
+vector<TrainingRecord> playGame(uint32_t game, uint64_t nodes, TranspositionTable& table, mt19937_64& generator){
+    vector<TrainingRecord> records;
+    vector<vector<int>> board = startingBoard;
+    vector<uint64_t> history;
+    int result = 0, decidedPlies = 0;
+    table.clear();
+
+    //The random opening is played again if it ends the game
+
+    for(int ply = 0; ply < RANDOM_PLIES; ply++){
+        vector<vector<vector<int>>> moveList = generateMoves(board);
+        if(moveList.empty()){
+            board = startingBoard;
+            history.clear();
+            ply = -1;
+            continue;
+        }
+        history.push_back(zobristKey(board));
+        board = moveList[generator() % moveList.size()];
+    }
+
+    for(int ply = RANDOM_PLIES; ply < MAX_PLIES; ply++){
+        uint64_t key = zobristKey(board);
+        if(board[8][6] >= 100 || count(history.begin(), history.end(), key) >= 2){
+            break;
+        }
+        SearchLimits limits;
+        limits.nodes = nodes;
+        limits.useBook = false;
+        limits.table = &table;
+        SearchResult search = searchPosition(board, limits, history);
+        if(search.bestBoard.size() == 1){
+
+            //Checkmate gives {{player}} with the loser to move, stalemate {{0}}
+
+            result = -search.bestBoard[0][0];
+            break;
+        }
+
+        TrainingRecord record;
+        packBoard(board, record.board);
+        record.score = scoreToCentipawns(search.evaluation);
+        record.result = 0;
+        record.ply = (uint8_t)min(ply, 255);
+        record.game = game;
+        records.push_back(record);
+
+        decidedPlies = (abs(search.evaluation) > RESIGN_SCORE) ? decidedPlies + 1 : 0;
+        if(decidedPlies >= RESIGN_PLIES){
+            result = (search.evaluation > 0) ? 1 : -1;
+            break;
+        }
+        history.push_back(key);
+        board = search.bestBoard;
+    }
+    for(TrainingRecord& record : records){
+        record.result = (int8_t)result;
+    }
+    return records;
+}
+
+int main(int argc, char* argv[]){
+
+    if(argc < 4){
+        cerr << "Usage: " << argv[0] << " <output> <games> <nodes> [--Name value ...]" << endl;
+        return 1;
+    }
+    uint32_t games = (uint32_t)max(0, atoi(argv[2]));
+    uint64_t nodes = max(1ULL, strtoull(argv[3], nullptr, 10));
+    parseOptions(argc - 3, argv + 3);
+
+    //Game numbers continue after the last record already in the file
+
+    uint32_t firstGame = 0;
+    ifstream existing(argv[1], ios::binary | ios::ate);
+    if(existing && existing.tellg() >= (streamoff)sizeof(TrainingRecord)){
+        TrainingRecord last;
+        existing.seekg(existing.tellg() / sizeof(TrainingRecord) * sizeof(TrainingRecord) - sizeof(TrainingRecord));
+        if(existing.read((char*)&last, sizeof(last))){
+            firstGame = last.game + 1;
+        }
+    }
+    existing.close();
+    nextGame = firstGame;
+    games += firstGame;
+
+    output = fopen(argv[1], "ab");
+    if(!output){
+        cerr << "Could not open " << argv[1] << endl;
+        return 1;
+    }
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    vector<thread> workers;
+    for(int i = 0; i < threadCount; i++){
+        workers.emplace_back([&, i](){
+            TranspositionTable table(TABLE_ENTRIES);
+            mt19937_64 generator(random_device{}() ^ (uint64_t)i << 32);
+            uint32_t game;
+            while((game = nextGame.fetch_add(1)) < games){
+                vector<TrainingRecord> records = playGame(game, nodes, table, generator);
+                lock_guard<mutex> guard(outputLock);
+                fwrite(records.data(), sizeof(TrainingRecord), records.size(), output);
+                uint64_t written = positionsWritten += records.size();
+                double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+                cout << "game " << game + 1 - firstGame << "/" << games - firstGame << " result " << (int)(records.empty() ? 0 : records[0].result)
+                    << " positions " << written << " (" << (uint64_t)(written / max(seconds, 1e-9)) << "/s)" << endl;
+            }
+        });
+    }
+    for(thread& worker : workers){
+        worker.join();
+    }
+    fclose(output);
+
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << "games " << games - firstGame << ", positions " << positionsWritten << " in " << seconds << "s, "
+        << positionsWritten / max(seconds, 1e-9) << " positions/s, workers " << threadCount << endl;
+    return 0;
+}
@@ -0,0 +1,378 @@
+/**
+ * @file server.cpp
+ * @brief Implementation of the engine server.
+ *
+ * @author Anshuman Routray
+ */
+
+#include "server.hpp"
+#include "notation.hpp"
+#include "options.hpp"
+#include "zobrist.hpp"
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+using namespace std;
+
+static const int defaultBudget = 100; //Milliseconds per search unless the session says otherwise
+
+/**
+ * Finds the move the opponent is expected to answer with, for the client to ponder on. A small
+ * search is enough, it only has to be right often.
+ *
+ * @return The move in coordinate notation, or "none" if the game is over.
+ */
+static string expectedReply(const vector<vector<int>>& board, const vector<uint64_t>& history){
+    SearchLimits limits;
+    limits.depth = 2;
+    limits.nodes = 200;
+    SearchResult reply = searchPosition(board, limits, history);
+    if(reply.bestBoard.size() == 1){
+        return "none";
+    }
+    return moveToString(board, reply.bestBoard);
+}
+
+EngineServer::EngineServer(int workerCount, function<void(const string&)> output, chrono::milliseconds sessionTimeout)
+    : output(output), sessionTimeout(sessionTimeout), running(0), stopping(false){
+    for(int i = 0; i < max(workerCount, 1); i++){
+        workers.emplace_back(&EngineServer::workerLoop, this);
+    }
+}
+
+EngineServer::~EngineServer(){
+    {
+        lock_guard<mutex> guard(lock);
+        stopping = true;
+    }
+    wakeWorkers.notify_all();
+    for(thread& worker : workers){
+        worker.join();
+    }
+}
+
+void EngineServer::reply(const string& line){
+    lock_guard<mutex> guard(outputLock);
+    output(line);
+}
+
+void EngineServer::waitIdle(){
+    unique_lock<mutex> guard(lock);
+    idle.wait(guard, [this]{ return jobs.empty() && running == 0; });
+}
+
+void EngineServer::closeIdleSessions(chrono::steady_clock::time_point now){
+    for(auto it = sessions.begin(); it != sessions.end();){
+        if(!it->second.searching && now - it->second.lastActive > sessionTimeout){
+            it = sessions.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+}
+
+bool EngineServer::handleCommand(const string& line){
+    istringstream input(line);
+    string id, command;
+    if(!(input >> id)){
+        return true;
+    }
+    if(id == "quit"){
+        waitIdle();
+        return false;
+    }
+    input >> command;
+
+    chrono::steady_clock::time_point now = chrono::steady_clock::now();
+    unique_lock<mutex> guard(lock);
+    closeIdleSessions(now);
+
+    //A session starts at the starting position the first time its name is used
+
+    auto found = sessions.find(id);
+    if(found == sessions.end()){
+        if(command == "quit"){
+            return true;
+        }
+        found = sessions.emplace(id, Session{startingBoard, {}, defaultBudget, false, nullptr, nullptr, now, now, 0}).first;
+    }
+    Session& session = found->second;
+    chrono::steady_clock::duration idleTime = now - session.lastActive;
+    session.lastActive = now;
+
+    string error;
+    if(session.searching && (command == "position" || command == "move" || command == "go" || command == "quit")){
+        error = "searching";
+    }
+    else if(command == "position"){
+        string type;
+        input >> type;
+        if(type == "startpos"){
+            session.board = startingBoard;
+            session.history.clear();
+        }
+        else if(type == "board"){
+            vector<vector<int>> board(9, vector<int>(8, 0));
+            board[8].resize(7, 0);
+            bool valid = true;
+            for(int i = 0; i < 64 && valid; i++){
+                valid = (bool)(input >> board[i / 8][i % 8]);
+            }
+
+            //Like genMove, a missing half move clock reads as 0
+
+            for(int i = 0; i < 7 && valid; i++){
+                if(!(input >> board[8][i]) && i < 6){
+                    valid = false;
+                }
+            }
+            if(valid){
+                session.board = board;
+                session.history.clear();
+            }
+            else {
+                error = "bad board";
+            }
+        }
+        else if(type == "fen"){
+            string fen;
+            getline(input, fen);
+            vector<vector<int>> board = boardFromFen(fen);
+            if(board.empty()){
+                error = "bad fen";
+            }
+            else {
+                session.board = board;
+                session.history.clear();
+            }
+        }
+        else {
+            error = "unknown position " + type;
+        }
+    }
+    else if(command == "move"){
+        string move;
+        input >> move;
+        vector<vector<int>> newBoard = findMove(session.board, move);
+        if(newBoard.empty()){
+            error = "illegal move " + move;
+        }
+        else {
+            session.history.push_back(zobristKey(session.board));
+            session.board = newBoard;
+        }
+    }
+    else if(command == "go"){
+        Job job{id, session.board, session.history, SearchLimits(), make_shared<atomic<bool>>(false), nullptr, now};
+        job.limits.stop = job.stop.get();
+        job.limits.multiPV = multiPVCount;
+        if(!skillLevel.empty()){
+            applySkillLevel(skillLevel, job.limits);
+        }
+        int budget = session.budget;
+        vector<string> words;
+        string word;
+        while(input >> word){
+            words.push_back(word);
+        }
+        size_t next = 0;
+        if(!words.empty() && words[0] == "ponder"){
+            job.ponder = make_shared<atomic<bool>>(true);
+            job.limits.ponder = job.ponder.get();
+            next = 1;
+        }
+        for(; error.empty() && next + 1 < words.size(); next += 2){
+            const string& name = words[next];
+            const string& value = words[next + 1];
+            if(name == "movetime"){
+                budget = atoi(value.c_str());
+            }
+            else if(name == "depth"){
+                job.limits.depth = max(1, min(atoi(value.c_str()), maxPly));
+            }
+            else if(name == "nodes"){
+                job.limits.nodes = max(1ULL, strtoull(value.c_str(), nullptr, 10));
+            }
+            else if(name == "multipv"){
+                job.limits.multiPV = max(1, atoi(value.c_str()));
+            }
+            else if(name == "skill"){
+                if(!applySkillLevel(value, job.limits)){
+                    error = "unknown skill " + value;
+                }
+            }
+            else {
+                error = "unknown limit " + name;
+            }
+        }
+        if(!error.empty()){
+            guard.unlock();
+            reply(id + " error " + error);
+            return true;
+        }
+
+        //The budget counts from the moment the command arrived, waiting in the queue included
+
+        job.limits.deadline = now + chrono::milliseconds(budget);
+        session.searching = true;
+        session.stop = job.stop;
+        session.ponder = job.ponder;
+        session.searches++;
+        jobs.push_back(move(job));
+        wakeWorkers.notify_one();
+    }
+    else if(command == "stop"){
+
+        //The search checks the flag from its first node, a search still waiting in the queue answers
+        //with its first legal move as soon as a worker takes it
+
+        if(session.searching){
+            session.stop->store(true, memory_order_relaxed);
+        }
+    }
+    else if(command == "ponderhit"){
+        if(session.searching && session.ponder){
+            session.ponder->store(false, memory_order_relaxed);
+        }
+        else {
+            error = "not pondering";
+        }
+    }
+    else if(command == "board"){
+        ostringstream reply;
+        reply << id << " board";
+        for(int i = 0; i < 8; i++){
+            for(int j = 0; j < 8; j++){
+                reply << " " << session.board[i][j];
+            }
+        }
+        for(int value : session.board[8]){
+            reply << " " << value;
+        }
+        guard.unlock();
+        this->reply(reply.str());
+        return true;
+    }
+    else if(command == "fen"){
+        string fen = boardToFen(session.board);
+        guard.unlock();
+        reply(id + " fen " + fen);
+        return true;
+    }
+    else if(command == "budget"){
+        int budget;
+        if(input >> budget && budget > 0){
+            session.budget = budget;
+        }
+        else {
+            error = "bad budget";
+        }
+    }
+    else if(command == "status"){
+        ostringstream status;
+        status << id << " status age " << chrono::duration_cast<chrono::milliseconds>(now - session.created).count()
+            << " idle " << chrono::duration_cast<chrono::milliseconds>(idleTime).count() << " plies " << session.history.size()
+            << " searches " << session.searches
+            << " budget " << session.budget << " sessions " << sessions.size() << " queued " << jobs.size();
+        guard.unlock();
+        reply(status.str());
+        return true;
+    }
+    else if(command == "quit"){
+        sessions.erase(found);
+    }
+    else {
+        error = "unknown command " + command;
+    }
+    guard.unlock();
+    if(!error.empty()){
+        reply(id + " error " + error);
+    }
+    return true;
+}
+
+void EngineServer::workerLoop(){
+    while(true){
+        Job job;
+        {
+            unique_lock<mutex> guard(lock);
+            wakeWorkers.wait(guard, [this]{ return stopping || !jobs.empty(); });
+            if(jobs.empty()){
+                return;
+            }
+            job = move(jobs.front());
+            jobs.pop_front();
+            running++;
+        }
+
+        SearchResult result = searchPosition(job.board, job.limits, job.history);
+
+        for(size_t i = 0; i < result.lines.size(); i++){
+            ostringstream info;
+            info << job.id << " info multipv " << i + 1 << " depth " << result.depth << " score " << fixed
+                << setprecision(2) << result.lines[i].evaluation << " pv";
+            for(int move : result.lines[i].moves){
+                info << " " << moveName(move);
+            }
+            reply(info.str());
+        }
+        ostringstream line;
+
+        //The principal variation already says what the opponent is expected to play, unless it was cut short
+
+        line << job.id << " bestmove ";
+        if(result.bestBoard.size() == 1){
+            line << "none";
+        }
+        else if(result.lines[0].moves.size() >= 2){
+            line << moveName(result.lines[0].moves[0]) << " ponder " << moveName(result.lines[0].moves[1]);
+        }
+        else {
+            job.history.push_back(zobristKey(job.board));
+            line << moveToString(job.board, result.bestBoard) << " ponder " << expectedReply(result.bestBoard, job.history);
+        }
+        chrono::steady_clock::time_point finished = chrono::steady_clock::now();
+        line << " score " << fixed << setprecision(2) << result.evaluation << " depth " << result.depth
+            << " rootmoves " << result.rootMoves << " nodes " << result.nodes << " time "
+            << chrono::duration_cast<chrono::milliseconds>(finished - job.queued).count();
+        if(result.fromBook){
+            line << " book";
+        }
+        else if(result.fromTablebase){
+            line << " tablebase";
+        }
+
+        {
+            lock_guard<mutex> guard(lock);
+            auto found = sessions.find(job.id);
+            if(found != sessions.end()){
+                found->second.searching = false;
+                found->second.stop = nullptr;
+                found->second.ponder = nullptr;
+                found->second.lastActive = finished;
+            }
+        }
+        reply(line.str());
+        {
+            lock_guard<mutex> guard(lock);
+            running--;
+        }
+        idle.notify_all();
+    }
+}
+
+void runServer(int workerCount){
+    EngineServer server(workerCount, [](const string& line){
+        cout << line << endl;
+    });
+    string line;
+    while(getline(cin, line)){
+        if(!server.handleCommand(line)){
+            break;
+        }
+    }
+    server.waitIdle();
+}
@@ -0,0 +1,131 @@
+/**
+ * @file server.hpp
+ * @brief Declaration of the engine server, which plays many games at once in one process.
+ *
+ * Every game is a session with its own name. Commands for any session can arrive in any order,
+ * searches are queued and run on a fixed pool of worker threads, which all share one
+ * transposition table. Each line of input is one command, each line of output one reply:
+ *
+ * - `<id> position startpos` / `<id> position board <64 squares> <7 metadata values>` / `<id> position fen <fen>`
+ * - `<id> move <move>` plays a move in coordinate notation (e2e4, e7e8q)
+ * - `<id> go [ponder] [movetime <ms>] [depth <n>] [nodes <n>] [multipv <n>] [skill <level>]` replies
+ *   `<id> bestmove <move> ponder <move> score <pawns> depth <n> rootmoves <n> nodes <n> time <ms> [book|tablebase]`,
+ *   after one `<id> info multipv <k> depth <n> score <pawns> pv <moves>` line per line asked for with `multipv <n>`.
+ *   `rootmoves` counts the root moves searched at that depth, every legal move unless a mate in one was found
+ * - `<id> ponderhit` tells a pondering session that the opponent played the expected move
+ * - `<id> stop` ends the session's search early, it still replies with the best move found so far
+ * - `<id> board` replies `<id> board <64 squares> <7 metadata values>`
+ * - `<id> fen` replies `<id> fen <fen>`, with 1 as the full move number
+ * - `<id> budget <ms>` sets the default time of the session's searches
+ * - `<id> status` replies with the session's age, idle time and number of searches
+ * - `<id> quit` ends the session, `quit` waits for every search and stops the server
+ *
+ * Pondering works like in UCI: after a reply the client plays the engine's move and the expected
+ * `ponder` move, then sends `go ponder`. The search runs on the opponent's time. If the opponent
+ * plays that move the client sends `ponderhit` and the search carries on as a normal one, with its
+ * limits counted from then; otherwise it sends `stop`, ignores the reply and sets up the real position.
+ *
+ * A skill level (see `applySkillLevel`) sets a node budget and makes the engine misjudge positions on
+ * purpose, so weaker games also cost less to serve. The `--Skill` option sets the level of every search
+ * that does not name one.
+ *
+ * Errors are replied as `<id> error <reason>`. Sessions that have been idle too long are closed.
+ *
+ * @author Anshuman Routray
+ */
+
+#ifndef SERVER_HPP
+#define SERVER_HPP
+
+#include "search.hpp"
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+
+using namespace std;
+
+class EngineServer {
+public:
+
+    /**
+     * @brief Starts the worker threads.
+     *
+     * @param workerCount: Number of searches that can run at the same time
+     *
+     * @param output: Receives every reply, one line at a time (without the newline)
+     *
+     * @param sessionTimeout: Sessions idle for longer than this are closed
+     */
+    EngineServer(int workerCount, function<void(const string&)> output,
+        chrono::milliseconds sessionTimeout = chrono::minutes(10));
+
+    /**
+     * @brief Waits for the queued searches and stops the worker threads.
+     */
+    ~EngineServer();
+
+    EngineServer(const EngineServer&) = delete;
+    EngineServer& operator=(const EngineServer&) = delete;
+
+    /**
+     * @brief Handles one line of input.
+     *
+     * @return False once the server was told to quit, otherwise true.
+     */
+    bool handleCommand(const string& line);
+
+    /**
+     * @brief Blocks until no search is queued or running.
+     */
+    void waitIdle();
+
+private:
+    struct Session {
+        vector<vector<int>> board;
+        vector<uint64_t> history;   // keys of the positions before the current one
+        int budget;                 // default search time in milliseconds
+        bool searching;
+        shared_ptr<atomic<bool>> stop;  // stop flag of the running search
+        shared_ptr<atomic<bool>> ponder;    // set while the running search is pondering
+        chrono::steady_clock::time_point created;
+        chrono::steady_clock::time_point lastActive;
+        uint64_t searches;
+    };
+
+    struct Job {
+        string id;
+        vector<vector<int>> board;
+        vector<uint64_t> history;
+        SearchLimits limits;
+        shared_ptr<atomic<bool>> stop;
+        shared_ptr<atomic<bool>> ponder;
+        chrono::steady_clock::time_point queued;
+    };
+
+    void workerLoop();
+    void closeIdleSessions(chrono::steady_clock::time_point now);
+    void reply(const string& line);
+
+    function<void(const string&)> output;
+    chrono::milliseconds sessionTimeout;
+    mutex lock;
+    mutex outputLock;
+    condition_variable wakeWorkers;
+    condition_variable idle;
+    deque<Job> jobs;
+    map<string, Session> sessions;
+    vector<thread> workers;
+    int running;
+    bool stopping;
+};
+
+/**
+ * @brief Runs a server that reads commands from standard input and writes replies to standard output.
+ */
+void runServer(int workerCount);
+
+#endif
@@ -0,0 +1,1035 @@
+/**
+ * @file tablebase.cpp
+ * @brief Implementation of the Syzygy tablebase prober.
+ *
+ * Squares are numbered like the table files number them, a1 = 0, b1 = 1, ..., h8 = 63, and pieces
+ * like their piece bytes: 1 to 6 for the white pawn to king and 9 to 14 for the black ones.
+ *
+ * @author Anshuman Routray
+ */
+
+#include "tablebase.hpp"
+#include "search.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+using namespace std;
+
+Tablebases tablebases;
+
+const int tablebaseLoss = -2;
+const int tablebaseBlessedLoss = -1;
+const int tablebaseDraw = 0;
+const int tablebaseCursedWin = 1;
+const int tablebaseWin = 2;
+
+static const int maxTablePieces = 7;
+static const int maxDtz = 1 << 18;     // above any DTZ, ranks root moves
+
+//Flags of a table part
+
+static const int sideToMoveFlag = 1;     // a DTZ part stores black to move
+static const int mappedFlag = 2;         // DTZ values go through a map
+static const int winPliesFlag = 4;       // DTZ of wins in plies rather than moves
+static const int lossPliesFlag = 8;      // DTZ of losses in plies rather than moves
+static const int wideFlag = 16;          // the map has 16 bit values
+static const int singleValueFlag = 128;  // every position has the same value
+
+static const unsigned char wdlMagic[4] = {0x71, 0xE8, 0x23, 0x5D};
+static const unsigned char dtzMagic[4] = {0xD7, 0x66, 0x0C, 0xA5};
+
+//A part of a table: one side to move and, for pawns, one file of the leading pawn
+
+struct PairsData {
+    int flags = 0;
+    uint64_t blockSize = 0;
+    uint64_t span = 0;              // values between two entries of the sparse index
+    uint64_t sparseIndexSize = 0;
+    uint64_t blockCount = 0;
+    uint64_t blockLengthSize = 0;
+    int maxSymbolLength = 0;
+    int minSymbolLength = 0;        // the value itself for single value parts
+    const unsigned char* lowestSymbol = nullptr;
+    const unsigned char* pairs = nullptr;   // the two symbols every symbol stands for, 12 bits each
+    vector<uint64_t> base;          // lowest code of every length, left aligned
+    vector<uint8_t> symbolLength;   // values a symbol stands for, minus one
+    const unsigned char* sparseIndex = nullptr;
+    const unsigned char* blockLength = nullptr;
+    const unsigned char* data = nullptr;
+    int pieces[maxTablePieces] = {};
+    int groupLength[maxTablePieces + 1] = {};
+    uint64_t groupIndex[maxTablePieces + 1] = {};
+    int mapOffset[4] = {};          // DTZ maps of win, loss, cursed win and blessed loss
+};
+
+struct SyzygyFile {
+    string path;
+    MappedFile file;
+    atomic<bool> ready{false};
+    bool broken = false;
+    PairsData parts[2][4];          // side to move, file of the leading pawn
+    const unsigned char* map = nullptr;
+};
+
+struct SyzygyTable {
+    string code;
+    int pieceCount = 0;
+    bool hasPawns = false;
+    bool hasUniquePieces = false;
+    bool symmetric = false;         // both sides have the same pieces
+    int pawnCount[2] = {0, 0};      // pawns of the leading colour and of the other one
+    SyzygyFile wdl, dtz;
+};
+
+//Index tables, built once
+
+static int mapB1H1H7[64];
+static int mapA1D1D4[64];
+static int mapKK[10][64];
+static uint64_t binomial[maxTablePieces][64];
+static int mapPawns[64];
+static uint64_t leadPawnIndex[maxTablePieces][64];
+static uint64_t leadPawnsSize[maxTablePieces][4];
+
+static int rankOf(int square){ return square >> 3; }
+static int fileOf(int square){ return square & 7; }
+
+//Positive above the a1-h8 diagonal, negative below it
+
+static int offDiagonal(int square){
+    return rankOf(square) - fileOf(square);
+}
+
+static bool pawnOrder(int a, int b){
+    return mapPawns[a] < mapPawns[b];
+}
+
+static bool initIndexTables(){
+    int code = 0;
+    for(int square = 0; square < 64; square++){
+        if(offDiagonal(square) < 0){
+            mapB1H1H7[square] = code++;
+        }
+    }
+
+    //The a1-d1-d4 triangle, the squares on the diagonal last
+
+    vector<int> diagonal;
+    code = 0;
+    for(int square = 0; square <= 27; square++){
+        if(offDiagonal(square) < 0 && fileOf(square) <= 3){
+            mapA1D1D4[square] = code++;
+        }
+        else if(offDiagonal(square) == 0 && fileOf(square) <= 3){
+            diagonal.push_back(square);
+        }
+    }
+    for(int square : diagonal){
+        mapA1D1D4[square] = code++;
+    }
+
+    //The 462 placements of two kings with the first in the triangle, both on the diagonal last
+
+    vector<pair<int, int>> bothOnDiagonal;
+    code = 0;
+    for(int index = 0; index < 10; index++){
+        for(int first = 0; first <= 27; first++){
+            if(mapA1D1D4[first] != index || (index == 0 && first != 1)){
+                continue;
+            }
+            for(int second = 0; second < 64; second++){
+                if(abs(rankOf(first) - rankOf(second)) <= 1 && abs(fileOf(first) - fileOf(second)) <= 1){
+                    continue;
+                }
+                if(offDiagonal(first) == 0 && offDiagonal(second) > 0){
+                    continue;
+                }
+                if(offDiagonal(first) == 0 && offDiagonal(second) == 0){
+                    bothOnDiagonal.push_back({index, second});
+                }
+                else {
+                    mapKK[index][second] = code++;
+                }
+            }
+        }
+    }
+    for(const pair<int, int>& kings : bothOnDiagonal){
+        mapKK[kings.first][kings.second] = code++;
+    }
+
+    binomial[0][0] = 1;
+    for(int n = 1; n < 64; n++){
+        for(int k = 0; k < maxTablePieces && k <= n; k++){
+            binomial[k][n] = ((k > 0) ? binomial[k - 1][n - 1] : 0) + ((k < n) ? binomial[k][n - 1] : 0);
+        }
+    }
+
+    //A pawn's number is the squares left for the other pawns when it leads: the leading pawn is
+    //the one nearest the edge, and the lowest of those
+
+    int available = 47;
+    for(int leadPawns = 1; leadPawns <= 5; leadPawns++){
+        for(int file = 0; file < 4; file++){
+            uint64_t index = 0;
+            for(int rank = 1; rank <= 6; rank++){
+                int square = rank * 8 + file;
+                if(leadPawns == 1){
+                    mapPawns[square] = available--;
+                    mapPawns[square ^ 7] = available--;
+                }
+                leadPawnIndex[leadPawns][square] = index;
+                index += binomial[leadPawns - 1][mapPawns[square]];
+            }
+            leadPawnsSize[leadPawns][file] = index;
+        }
+    }
+    return code == 462;
+}
+
+static const bool indexTablesReady = initIndexTables();
+
+static uint16_t readLittle16(const unsigned char* bytes){
+    return (uint16_t)(bytes[0] | (bytes[1] << 8));
+}
+
+static uint32_t readLittle32(const unsigned char* bytes){
+    return (uint32_t)bytes[0] | ((uint32_t)bytes[1] << 8) | ((uint32_t)bytes[2] << 16) | ((uint32_t)bytes[3] << 24);
+}
+
+static uint32_t readBig32(const unsigned char* bytes){
+    return ((uint32_t)bytes[0] << 24) | ((uint32_t)bytes[1] << 16) | ((uint32_t)bytes[2] << 8) | (uint32_t)bytes[3];
+}
+
+static uint64_t readBig64(const unsigned char* bytes){
+    return ((uint64_t)readBig32(bytes) << 32) | readBig32(bytes + 4);
+}
+
+static int leftSymbol(const PairsData& d, int symbol){
+    const unsigned char* pair = d.pairs + 3 * symbol;
+    return ((pair[1] & 0xF) << 8) | pair[0];
+}
+
+static int rightSymbol(const PairsData& d, int symbol){
+    const unsigned char* pair = d.pairs + 3 * symbol;
+    return (pair[2] << 4) | (pair[1] >> 4);
+}
+
+static int setSymbolLength(PairsData& d, int symbol, vector<bool>& visited){
+    visited[symbol] = true;
+    int right = rightSymbol(d, symbol);
+    if(right == 0xFFF){
+        return 0;
+    }
+    int left = leftSymbol(d, symbol);
+    if(!visited[left]){
+        d.symbolLength[left] = (uint8_t)setSymbolLength(d, left, visited);
+    }
+    if(!visited[right]){
+        d.symbolLength[right] = (uint8_t)setSymbolLength(d, right, visited);
+    }
+    return d.symbolLength[left] + d.symbolLength[right] + 1;
+}
+
+/**
+ * Splits the pieces of a part into the groups its index is made of and works out what every
+ * group is multiplied by. The leading group holds the kings and one more unique piece (or just
+ * the kings), or the leading pawns, every other group the pieces of one kind.
+ */
+static void setGroups(const SyzygyTable& table, PairsData& d, const int order[2], int file){
+    int n = 0, firstLength = table.hasPawns ? 0 : table.hasUniquePieces ? 3 : 2;
+    d.groupLength[n] = 1;
+    for(int i = 1; i < table.pieceCount; i++){
+        if(--firstLength > 0 || d.pieces[i] == d.pieces[i - 1]){
+            d.groupLength[n]++;
+        }
+        else {
+            d.groupLength[++n] = 1;
+        }
+    }
+    d.groupLength[++n] = 0;
+
+    //Groups are multiplied in the order the table chose, the leading group at order[0] and the
+    //other colour's pawns at order[1]
+
+    bool pawnsBothSides = table.hasPawns && table.pawnCount[1];
+    int next = pawnsBothSides ? 2 : 1;
+    int freeSquares = 64 - d.groupLength[0] - (pawnsBothSides ? d.groupLength[1] : 0);
+    uint64_t index = 1;
+    for(int k = 0; next < n || k == order[0] || k == order[1]; k++){
+        if(k == order[0]){
+            d.groupIndex[0] = index;
+            index *= table.hasPawns ? leadPawnsSize[d.groupLength[0]][file] : table.hasUniquePieces ? 31332 : 462;
+        }
+        else if(k == order[1]){
+            d.groupIndex[1] = index;
+            index *= binomial[d.groupLength[1]][48 - d.groupLength[0]];
+        }
+        else {
+            d.groupIndex[next] = index;
+            index *= binomial[d.groupLength[next]][freeSquares];
+            freeSquares -= d.groupLength[next++];
+        }
+    }
+    d.groupIndex[n] = index;
+}
+
+/**
+ * Reads the sizes and the Huffman code of a part.
+ *
+ * @return Where the next part starts.
+ */
+static const unsigned char* setSizes(PairsData& d, const unsigned char* data){
+    d.flags = *data++;
+    if(d.flags & singleValueFlag){
+        d.minSymbolLength = *data++;
+        return data;
+    }
+    int groupEnd = 0;
+    while(d.groupLength[groupEnd]){
+        groupEnd++;
+    }
+    uint64_t tableSize = d.groupIndex[groupEnd];
+    d.blockSize = 1ULL << *data++;
+    d.span = 1ULL << *data++;
+    d.sparseIndexSize = (tableSize + d.span - 1) / d.span;
+    int padding = *data++;
+    d.blockCount = readLittle32(data);
+    data += 4;
+    d.blockLengthSize = d.blockCount + padding;
+    d.maxSymbolLength = *data++;
+    d.minSymbolLength = *data++;
+    d.lowestSymbol = data;
+
+    //Canonical Huffman code: longer codes have lower values, base[i] is the lowest code of length
+    //minSymbolLength + i, left aligned in 64 bits so codes compare like the bits read
+
+    size_t lengths = d.maxSymbolLength - d.minSymbolLength + 1;
+    d.base.assign(lengths, 0);
+    for(int i = (int)lengths - 2; i >= 0; i--){
+        d.base[i] = (d.base[i + 1] + readLittle16(d.lowestSymbol + 2 * i) - readLittle16(d.lowestSymbol + 2 * (i + 1))) / 2;
+    }
+    for(size_t i = 0; i < lengths; i++){
+        d.base[i] <<= 64 - i - d.minSymbolLength;
+    }
+    data += lengths * 2;
+    size_t symbols = readLittle16(data);
+    data += 2;
+    d.pairs = data;
+    d.symbolLength.assign(symbols, 0);
+    vector<bool> visited(symbols, false);
+    for(size_t symbol = 0; symbol < symbols; symbol++){
+        if(!visited[symbol]){
+            d.symbolLength[symbol] = (uint8_t)setSymbolLength(d, (int)symbol, visited);
+        }
+    }
+    return data + symbols * 3 + (symbols & 1);
+}
+
+/**
+ * Finds the value at an index of a part.
+ */
+static int decompressPairs(const PairsData& d, uint64_t index){
+    if(d.flags & singleValueFlag){
+        return d.minSymbolLength;
+    }
+
+    //The sparse index gives the block and offset of every span-th value, from there the blocks
+    //are walked to the one holding the index
+
+    uint64_t k = index / d.span;
+    const unsigned char* entry = d.sparseIndex + 6 * k;
+    uint32_t block = readLittle32(entry);
+    int offset = readLittle16(entry + 4);
+    offset += (int)(index % d.span) - (int)(d.span / 2);
+    while(offset < 0){
+        offset += readLittle16(d.blockLength + 2 * --block) + 1;
+    }
+    while(offset > readLittle16(d.blockLength + 2 * block)){
+        offset -= readLittle16(d.blockLength + 2 * block++) + 1;
+    }
+
+    //Symbols are read until the one that covers the offset
+
+    const unsigned char* bytes = d.data + block * d.blockSize;
+    uint64_t buffer = readBig64(bytes);
+    bytes += 8;
+    int bufferBits = 64;
+    int symbol;
+    while(true){
+        int length = 0;
+        while(buffer < d.base[length]){
+            length++;
+        }
+        symbol = (int)((buffer - d.base[length]) >> (64 - length - d.minSymbolLength));
+        symbol += readLittle16(d.lowestSymbol + 2 * length);
+        if(offset < d.symbolLength[symbol] + 1){
+            break;
+        }
+        offset -= d.symbolLength[symbol] + 1;
+        length += d.minSymbolLength;
+        buffer <<= length;
+        bufferBits -= length;
+        if(bufferBits <= 32){
+            bufferBits += 32;
+            buffer |= (uint64_t)readBig32(bytes) << (64 - bufferBits);
+            bytes += 4;
+        }
+    }
+
+    //The symbol stands for a pair of symbols, each for a run of values, down to a single value
+
+    while(d.symbolLength[symbol]){
+        int left = leftSymbol(d, symbol);
+        if(offset < d.symbolLength[left] + 1){
+            symbol = left;
+        }
+        else {
+            offset -= d.symbolLength[left] + 1;
+            symbol = rightSymbol(d, symbol);
+        }
+    }
+    return leftSymbol(d, symbol);
+}
+
+/**
+ * Reads the header of a mapped table file and points every part at its data.
+ */
+static bool setTable(const SyzygyTable& table, SyzygyFile& tableFile, bool dtz){
+    const unsigned char* base = tableFile.file.data();
+    const unsigned char* end = base + tableFile.file.size();
+    if(tableFile.file.size() < 6 || memcmp(base, dtz ? dtzMagic : wdlMagic, 4) != 0){
+        return false;
+    }
+    const unsigned char* data = base + 4;
+    bool split = (*data & 1) != 0, pawns = (*data & 2) != 0;
+    if(pawns != table.hasPawns || (!dtz && split == table.symmetric)){
+        return false;
+    }
+    data++;
+
+    int sides = (!dtz && !table.symmetric) ? 2 : 1;
+    int lastFile = table.hasPawns ? 3 : 0;
+    bool pawnsBothSides = table.hasPawns && table.pawnCount[1];
+    for(int file = 0; file <= lastFile; file++){
+        for(int side = 0; side < sides; side++){
+            tableFile.parts[side][file] = PairsData();
+        }
+        int order[2][2] = {{*data & 0xF, pawnsBothSides ? *(data + 1) & 0xF : 0xF},
+                           {*data >> 4, pawnsBothSides ? *(data + 1) >> 4 : 0xF}};
+        data += 1 + pawnsBothSides;
+        for(int k = 0; k < table.pieceCount; k++, data++){
+            for(int side = 0; side < sides; side++){
+                tableFile.parts[side][file].pieces[k] = side ? (*data >> 4) : (*data & 0xF);
+            }
+        }
+        for(int side = 0; side < sides; side++){
+            setGroups(table, tableFile.parts[side][file], order[side], file);
+        }
+    }
+
+    //Mapped files start on a page, so positions in the file align like addresses
+
+    data += (data - base) & 1;
+    for(int file = 0; file <= lastFile; file++){
+        for(int side = 0; side < sides; side++){
+            data = setSizes(tableFile.parts[side][file], data);
+        }
+    }
+    if(dtz){
+        tableFile.map = data;
+        for(int file = 0; file <= lastFile; file++){
+            PairsData& d = tableFile.parts[0][file];
+            if(!(d.flags & mappedFlag)){
+                continue;
+            }
+            if(d.flags & wideFlag){
+                data += (data - base) & 1;
+                for(int i = 0; i < 4; i++){
+                    d.mapOffset[i] = (int)(data - tableFile.map) + 2;
+                    data += 2 * readLittle16(data) + 2;
+                }
+            }
+            else {
+                for(int i = 0; i < 4; i++){
+                    d.mapOffset[i] = (int)(data - tableFile.map) + 1;
+                    data += *data + 1;
+                }
+            }
+        }
+        data += (data - base) & 1;
+    }
+    for(int file = 0; file <= lastFile; file++){
+        for(int side = 0; side < sides; side++){
+            PairsData& d = tableFile.parts[side][file];
+            d.sparseIndex = data;
+            data += d.sparseIndexSize * 6;
+        }
+    }
+    for(int file = 0; file <= lastFile; file++){
+        for(int side = 0; side < sides; side++){
+            PairsData& d = tableFile.parts[side][file];
+            d.blockLength = data;
+            data += d.blockLengthSize * 2;
+        }
+    }
+    for(int file = 0; file <= lastFile; file++){
+        for(int side = 0; side < sides; side++){
+            PairsData& d = tableFile.parts[side][file];
+            data = base + (((data - base) + 0x3F) & ~(ptrdiff_t)0x3F);
+            d.data = data;
+            data += d.blockCount * d.blockSize;
+        }
+    }
+    return data <= end;
+}
+
+//Pieces of a side in the order of table names, the king first
+
+static string sideCode(const int counts[7]){
+    static const char names[] = " PNBRQK";
+    string code = "K";
+    for(int kind = queen; kind >= pawn; kind--){
+        code.append(counts[kind], names[kind]);
+    }
+    return code;
+}
+
+static string materialCode(const vector<vector<int>>& board, int& pieceCount){
+    int counts[2][7] = {};
+    pieceCount = 0;
+    for(int row = 0; row < 8; row++){
+        for(int column = 0; column < 8; column++){
+            int piece = board[row][column];
+            if(piece != space){
+                counts[piece > 0][abs(piece)]++;
+                pieceCount++;
+            }
+        }
+    }
+    return sideCode(counts[1]) + "v" + sideCode(counts[0]);
+}
+
+static bool fileExists(const string& path){
+    FILE* file = fopen(path.c_str(), "rb");
+    if(file){
+        fclose(file);
+    }
+    return file != nullptr;
+}
+
+Tablebases::Tablebases(){
+}
+
+Tablebases::~Tablebases(){
+}
+
+bool Tablebases::open(const string& paths){
+    close();
+    if(!indexTablesReady){
+        return false;
+    }
+#ifdef _WIN32
+    const char separator = ';';
+#else
+    const char separator = ':';
+#endif
+    vector<string> directories;
+    size_t start = 0;
+    while(start <= paths.size()){
+        size_t stop = paths.find(separator, start);
+        if(stop == string::npos){
+            stop = paths.size();
+        }
+        if(stop > start){
+            directories.push_back(paths.substr(start, stop - start));
+        }
+        start = stop + 1;
+    }
+
+    //Every material with up to seven pieces, each side's pieces from the strongest down
+
+    vector<vector<int>> sides(1);
+    for(size_t i = 0; i < sides.size(); i++){
+        if(sides[i].size() == maxTablePieces - 2){
+            continue;
+        }
+        for(int kind = sides[i].empty() ? queen : sides[i].back(); kind >= pawn; kind--){
+            vector<int> more = sides[i];
+            more.push_back(kind);
+            sides.push_back(more);
+        }
+    }
+    for(const vector<int>& strong : sides){
+        for(const vector<int>& weak : sides){
+            if(strong.size() + weak.size() > maxTablePieces - 2 || (strong.empty() && weak.empty())){
+                continue;
+            }
+            int strongCounts[7] = {}, weakCounts[7] = {};
+            for(int kind : strong){
+                strongCounts[kind]++;
+            }
+            for(int kind : weak){
+                weakCounts[kind]++;
+            }
+            string code = sideCode(strongCounts) + "v" + sideCode(weakCounts);
+            string wdlPath, dtzPath;
+            for(const string& directory : directories){
+                if(wdlPath.empty() && fileExists(directory + "/" + code + ".rtbw")){
+                    wdlPath = directory + "/" + code + ".rtbw";
+                }
+                if(dtzPath.empty() && fileExists(directory + "/" + code + ".rtbz")){
+                    dtzPath = directory + "/" + code + ".rtbz";
+                }
+            }
+            if(wdlPath.empty()){
+                continue;
+            }
+            unique_ptr<SyzygyTable> table(new SyzygyTable());
+            table->code = code;
+            table->pieceCount = (int)(strong.size() + weak.size()) + 2;
+            table->symmetric = (strong == weak);
+            int strongPawns = strongCounts[pawn], weakPawns = weakCounts[pawn];
+            table->hasPawns = strongPawns + weakPawns > 0;
+            for(int kind = pawn; kind < king; kind++){
+                table->hasUniquePieces = table->hasUniquePieces || strongCounts[kind] == 1 || weakCounts[kind] == 1;
+            }
+
+            //With pawns on both sides the side with fewer pawns leads, it compresses better
+
+            bool strongLeads = weakPawns == 0 || (strongPawns > 0 && weakPawns >= strongPawns);
+            table->pawnCount[0] = strongLeads ? strongPawns : weakPawns;
+            table->pawnCount[1] = strongLeads ? weakPawns : strongPawns;
+            table->wdl.path = wdlPath;
+            table->dtz.path = dtzPath;
+            tablesByMaterial[code] = table.get();
+            tablesByMaterial[sideCode(weakCounts) + "v" + sideCode(strongCounts)] = table.get();
+            largest = max(largest, table->pieceCount);
+            tables.push_back(move(table));
+        }
+    }
+    return isOpen();
+}
+
+void Tablebases::close(){
+    tablesByMaterial.clear();
+    tables.clear();
+    largest = 0;
+}
+
+SyzygyTable* Tablebases::findTable(const vector<vector<int>>& board, bool& flipped){
+    int pieceCount;
+    string code = materialCode(board, pieceCount);
+    map<string, SyzygyTable*>::iterator found = tablesByMaterial.find(code);
+    if(found == tablesByMaterial.end()){
+        return nullptr;
+    }
+    flipped = (found->second->code != code);
+    return found->second;
+}
+
+bool Tablebases::mapTable(SyzygyTable& table, bool dtz){
+    SyzygyFile& tableFile = dtz ? table.dtz : table.wdl;
+    if(tableFile.ready.load(memory_order_acquire)){
+        return !tableFile.broken;
+    }
+    lock_guard<mutex> guard(mappingLock);
+    if(!tableFile.ready.load(memory_order_relaxed)){
+        tableFile.broken = tableFile.path.empty() || !tableFile.file.open(tableFile.path, 0, false)
+            || !setTable(table, tableFile, dtz);
+        if(tableFile.broken){
+            tableFile.file.close();
+        }
+        tableFile.ready.store(true, memory_order_release);
+    }
+    return !tableFile.broken;
+}
+
+/**
+ * Looks a position up in its table, without trying captures first. A DTZ table only holds one
+ * side to move, changeSide is set if the position has the other one.
+ */
+int Tablebases::probeTable(const vector<vector<int>>& board, bool dtz, int wdl, bool& failed, bool& changeSide){
+    int pieceAt[64];
+    int pieceCount = 0;
+    for(int square = 0; square < 64; square++){
+        int piece = board[7 - square / 8][square % 8];
+        pieceAt[square] = (piece > 0) ? piece : (piece < 0) ? -piece + 8 : 0;
+        pieceCount += (piece != space);
+    }
+
+    //Two lone kings are a draw without a table
+
+    if(pieceCount == 2){
+        return dtz ? 0 : tablebaseDraw;
+    }
+    bool blackStronger = false;
+    SyzygyTable* table = findTable(board, blackStronger);
+    if(!table || !mapTable(*table, dtz)){
+        failed = true;
+        return 0;
+    }
+    SyzygyFile& tableFile = dtz ? table->dtz : table->wdl;
+
+    //Tables are stored with the first side of their name as white, and tables with the same pieces
+    //on both sides only with white to move, other positions are looked up with the colours swapped
+
+    int blackToMove = (board[8][2] == blackPlayer) ? 1 : 0;
+    bool swapColours = (table->symmetric && blackToMove) || blackStronger;
+    int flipColour = swapColours ? 8 : 0, flipSquares = swapColours ? 56 : 0;
+    int sideToMove = (swapColours ? 1 : 0) ^ blackToMove;
+
+    int squares[maxTablePieces], pieces[maxTablePieces];
+    int size = 0, leadPawnCount = 0, pawnFile = 0;
+    uint64_t leadPawns = 0;
+
+    //Tables with pawns have a part for every file of the leading pawn, the one nearest the edge
+
+    if(table->hasPawns){
+        int leadPiece = tableFile.parts[0][0].pieces[0] ^ flipColour;
+        for(int square = 0; square < 64; square++){
+            if(pieceAt[square] == leadPiece){
+                leadPawns |= 1ULL << square;
+                squares[size++] = square ^ flipSquares;
+            }
+        }
+        leadPawnCount = size;
+        swap(squares[0], *max_element(squares, squares + leadPawnCount, pawnOrder));
+        pawnFile = fileOf(squares[0]);
+        if(pawnFile > 3){
+            pawnFile = fileOf(squares[0] ^ 7);
+        }
+    }
+    if(dtz){
+        const PairsData& first = tableFile.parts[0][pawnFile];
+        if((first.flags & sideToMoveFlag) != sideToMove && !(table->symmetric && !table->hasPawns)){
+            changeSide = true;
+            return 0;
+        }
+    }
+    for(int square = 0; square < 64; square++){
+        if(pieceAt[square] && !(leadPawns & (1ULL << square))){
+            squares[size] = square ^ flipSquares;
+            pieces[size++] = pieceAt[square] ^ flipColour;
+        }
+    }
+    const PairsData& d = tableFile.parts[dtz ? 0 : sideToMove][pawnFile];
+
+    //The pieces are put in the order of the table
+
+    for(int i = leadPawnCount; i < size - 1; i++){
+        for(int j = i + 1; j < size; j++){
+            if(d.pieces[i] == pieces[j]){
+                swap(pieces[i], pieces[j]);
+                swap(squares[i], squares[j]);
+                break;
+            }
+        }
+    }
+
+    //The leading piece is mirrored onto the files a to d
+
+    if(fileOf(squares[0]) > 3){
+        for(int i = 0; i < size; i++){
+            squares[i] ^= 7;
+        }
+    }
+    uint64_t index;
+    if(table->hasPawns){
+        index = leadPawnIndex[leadPawnCount][squares[0]];
+        stable_sort(squares + 1, squares + leadPawnCount, pawnOrder);
+        for(int i = 1; i < leadPawnCount; i++){
+            index += binomial[i][mapPawns[squares[i]]];
+        }
+    }
+    else {
+
+        //Without pawns it is also mirrored onto the ranks 1 to 4, and onto the a1-d1-d4 triangle
+
+        if(rankOf(squares[0]) > 3){
+            for(int i = 0; i < size; i++){
+                squares[i] ^= 56;
+            }
+        }
+        for(int i = 0; i < d.groupLength[0]; i++){
+            if(!offDiagonal(squares[i])){
+                continue;
+            }
+            if(offDiagonal(squares[i]) > 0){
+                for(int j = i; j < size; j++){
+                    squares[j] = ((squares[j] >> 3) | (squares[j] << 3)) & 63;
+                }
+            }
+            break;
+        }
+        if(table->hasUniquePieces){
+            int adjust1 = squares[1] > squares[0];
+            int adjust2 = (squares[2] > squares[0]) + (squares[2] > squares[1]);
+            if(offDiagonal(squares[0])){
+                index = ((uint64_t)mapA1D1D4[squares[0]] * 63 + (squares[1] - adjust1)) * 62 + squares[2] - adjust2;
+            }
+            else if(offDiagonal(squares[1])){
+                index = (6 * 63 + rankOf(squares[0]) * 28 + mapB1H1H7[squares[1]]) * 62 + squares[2] - adjust2;
+            }
+            else if(offDiagonal(squares[2])){
+                index = 6 * 63 * 62 + 4 * 28 * 62 + rankOf(squares[0]) * 7 * 28 + (rankOf(squares[1]) - adjust1) * 28
+                    + mapB1H1H7[squares[2]];
+            }
+            else {
+                index = 6 * 63 * 62 + 4 * 28 * 62 + 4 * 7 * 28 + rankOf(squares[0]) * 7 * 6
+                    + (rankOf(squares[1]) - adjust1) * 6 + (rankOf(squares[2]) - adjust2);
+            }
+        }
+        else {
+            index = mapKK[mapA1D1D4[squares[0]]][squares[1]];
+        }
+    }
+
+    //Every other group is the combination of its squares, leaving out the squares taken before
+
+    index *= d.groupIndex[0];
+    int* groupSquares = squares + d.groupLength[0];
+    bool remainingPawns = table->hasPawns && table->pawnCount[1];
+    for(int next = 1; d.groupLength[next]; next++){
+        sort(groupSquares, groupSquares + d.groupLength[next]);
+        uint64_t combination = 0;
+        for(int i = 0; i < d.groupLength[next]; i++){
+            int below = 0;
+            for(int* square = squares; square < groupSquares; square++){
+                below += groupSquares[i] > *square;
+            }
+            combination += binomial[i + 1][groupSquares[i] - below - (remainingPawns ? 8 : 0)];
+        }
+        remainingPawns = false;
+        index += combination * d.groupIndex[next];
+        groupSquares += d.groupLength[next];
+    }
+    int value = decompressPairs(d, index);
+    if(!dtz){
+        return value - 2;
+    }
+
+    //DTZ values may go through a map and may count moves rather than plies
+
+    static const int wdlMap[] = {1, 3, 0, 2, 0};
+    if(d.flags & mappedFlag){
+        int offset = d.mapOffset[wdlMap[wdl + 2]];
+        value = (d.flags & wideFlag) ? readLittle16(tableFile.map + offset + 2 * value) : tableFile.map[offset + value];
+    }
+    if((wdl == tablebaseWin && !(d.flags & winPliesFlag)) || (wdl == tablebaseLoss && !(d.flags & lossPliesFlag))
+        || wdl == tablebaseCursedWin || wdl == tablebaseBlessedLoss){
+        value *= 2;
+    }
+    return value + 1;
+}
+
+static int countPieces(const vector<vector<int>>& board){
+    int count = 0;
+    for(int row = 0; row < 8; row++){
+        for(int column = 0; column < 8; column++){
+            count += (board[row][column] != space);
+        }
+    }
+    return count;
+}
+
+/**
+ * Tries the captures (and with checkZeroing the pawn moves) before looking the position up, the
+ * tables store whatever compresses best where one of them is the best move. zeroingBest is set if
+ * the best move is a capture or pawn move, the DTZ table cannot be trusted then.
+ */
+int Tablebases::searchWDL(const vector<vector<int>>& board, bool checkZeroing, bool& failed, bool& zeroingBest){
+    vector<vector<vector<int>>> moveList = generateMoves(board);
+    if(moveList.empty()){
+        zeroingBest = isInCheck(board);
+        return zeroingBest ? tablebaseLoss : tablebaseDraw;
+    }
+    int pieceCount = countPieces(board);
+    int best = tablebaseLoss;
+    size_t searched = 0;
+    for(const vector<vector<int>>& newBoard : moveList){
+        bool capture = countPieces(newBoard) < pieceCount;
+        if(!capture && !(checkZeroing && newBoard[8][6] == 0)){
+            continue;
+        }
+        searched++;
+        bool childZeroing = false;
+        int value = -searchWDL(newBoard, false, failed, childZeroing);
+        if(failed){
+            return tablebaseDraw;
+        }
+        if(value > best){
+            best = value;
+            if(value >= tablebaseWin){
+                zeroingBest = true;
+                return value;
+            }
+        }
+    }
+
+    //Positions where every move was tried need no table, they may not even be stored right
+
+    bool noMoreMoves = (searched == moveList.size());
+    int value = best;
+    if(!noMoreMoves){
+        bool changeSide = false;
+        value = probeTable(board, false, 0, failed, changeSide);
+        if(failed){
+            return tablebaseDraw;
+        }
+    }
+    if(best >= value){
+        zeroingBest = (best > tablebaseDraw || noMoreMoves);
+        return best;
+    }
+    zeroingBest = false;
+    return value;
+}
+
+static bool canProbe(const vector<vector<int>>& board, int largest){
+    return board[8][0] == bothCastlingDisabled && board[8][1] == bothCastlingDisabled && countPieces(board) <= largest;
+}
+
+//The DTZ of a position whose best move is a capture or pawn move, which is one ply from zeroing
+
+static int dtzBeforeZeroing(int wdl){
+    return (wdl == tablebaseWin) ? 1 : (wdl == tablebaseCursedWin) ? 101 : (wdl == tablebaseBlessedLoss) ? -101
+        : (wdl == tablebaseLoss) ? -1 : 0;
+}
+
+static int sign(int value){
+    return (value > 0) - (value < 0);
+}
+
+bool Tablebases::probeWDL(const vector<vector<int>>& board, int& wdl){
+    if(!canProbe(board, largest)){
+        return false;
+    }
+    bool failed = false, zeroingBest = false;
+    int value = searchWDL(board, false, failed, zeroingBest);
+    if(failed){
+        return false;
+    }
+    wdl = value;
+    return true;
+}
+
+bool Tablebases::probeDTZ(const vector<vector<int>>& board, int& dtz){
+    if(!canProbe(board, largest)){
+        return false;
+    }
+    bool failed = false, zeroingBest = false;
+    int wdl = searchWDL(board, true, failed, zeroingBest);
+    if(failed){
+        return false;
+    }
+    if(wdl == tablebaseDraw){
+        dtz = 0;
+        return true;
+    }
+    if(zeroingBest){
+        dtz = dtzBeforeZeroing(wdl);
+        return true;
+    }
+    bool changeSide = false;
+    int value = probeTable(board, true, wdl, failed, changeSide);
+    if(failed){
+        return false;
+    }
+    if(!changeSide){
+        dtz = (value + 100 * (wdl == tablebaseBlessedLoss || wdl == tablebaseCursedWin)) * sign(wdl);
+        return true;
+    }
+
+    //The table holds the other side to move, so every move is looked up one ply further
+
+    int best = 0xFFFF;
+    for(const vector<vector<int>>& newBoard : generateMoves(board)){
+        bool zeroing = newBoard[8][6] == 0;
+        int moveDtz;
+        if(zeroing){
+            bool childZeroing = false;
+            moveDtz = -dtzBeforeZeroing(searchWDL(newBoard, false, failed, childZeroing));
+            if(failed){
+                return false;
+            }
+        }
+        else {
+            if(!probeDTZ(newBoard, moveDtz)){
+                return false;
+            }
+            moveDtz = -moveDtz;
+        }
+        if(moveDtz == 1 && isInCheck(newBoard) && generateMoves(newBoard).empty()){
+            best = 1;
+        }
+        if(!zeroing){
+            moveDtz += sign(moveDtz);
+        }
+        if(moveDtz < best && sign(moveDtz) == sign(wdl)){
+            best = moveDtz;
+        }
+    }
+    dtz = (best == 0xFFFF) ? -1 : best;
+    return true;
+}
+
+vector<vector<int>> Tablebases::bestMove(const vector<vector<int>>& board, int& wdl){
+    if(!canProbe(board, largest)){
+        return {};
+    }
+    int clock = board[8][6];
+    vector<vector<int>> best;
+    int bestRank = INT32_MIN, bestDtz = 0;
+    for(const vector<vector<int>>& newBoard : generateMoves(board)){
+
+        //The DTZ of the move counted from this position: zeroing moves start the count again
+
+        int dtz;
+        if(newBoard[8][6] == 0){
+            int childWdl;
+            if(!probeWDL(newBoard, childWdl)){
+                return {};
+            }
+            dtz = dtzBeforeZeroing(-childWdl);
+        }
+        else {
+            if(!probeDTZ(newBoard, dtz)){
+                return {};
+            }
+            dtz = -dtz;
+            dtz += sign(dtz);
+        }
+        if(dtz == 2 && isInCheck(newBoard) && generateMoves(newBoard).empty()){
+            dtz = 1;
+        }
+
+        //Wins the fifty move rule allows rank highest, then wins it stops, draws, losses it saves
+        //and certain losses. Among equal moves the quickest win and the slowest loss are picked
+
+        int rank = (dtz > 0) ? ((dtz + clock <= 99) ? maxDtz : maxDtz - (dtz + clock))
+            : (dtz < 0) ? ((-dtz * 2 + clock < 100) ? -maxDtz : -maxDtz + (-dtz + clock)) : 0;
+        if(rank > bestRank || (rank == bestRank && dtz < bestDtz)){
+            bestRank = rank;
+            bestDtz = dtz;
+            best = newBoard;
+        }
+    }
+    wdl = (bestRank == maxDtz) ? tablebaseWin : (bestRank > 0) ? tablebaseCursedWin : (bestRank == 0) ? tablebaseDraw
+        : (bestRank > -maxDtz) ? tablebaseBlessedLoss : tablebaseLoss;
+    return best;
+}
+
+double tablebaseScore(int wdl, int player, int ply){
+
+    //Below every mate score, so the search never mistakes a known win for a mate
+
+    double winValue = mateValue - 2 * maxPly - ply;
+    if(wdl == tablebaseWin){
+        return player * winValue;
+    }
+    if(wdl == tablebaseLoss){
+        return -player * winValue;
+    }
+    return 0.0;
+}
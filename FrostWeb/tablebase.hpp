@@ -0,0 +1,135 @@
+/**
+ * @file tablebase.hpp
+ * @brief Declaration of the Syzygy endgame tablebases, which know the result of every position with few pieces.
+ *
+ * Syzygy tables come in two files per endgame, named after the material with the stronger side
+ * first (KQvK.rtbw, KRPvKR.rtbz, ...). WDL files (.rtbw) hold win, draw or loss for every position,
+ * including cursed wins and blessed losses, which are wins and losses that the fifty move rule
+ * turns into draws. DTZ files (.rtbz) hold the distance to the next capture or pawn move that keeps
+ * the result, which is what it takes to win without running into the fifty move rule.
+ *
+ * The files are memory-mapped the first time an endgame is probed, so every engine process on the
+ * machine shares them through the page cache. They are decoded the way the reference prober (and
+ * Fathom) reads them: positions are mapped to an index by the placement of their pieces, with
+ * mirrored positions sharing an index, and the index is looked up in blocks of Huffman coded
+ * symbols, each of which expands into a run of values.
+ *
+ * The tables know nothing about castling or the fifty move rule. Positions with castling rights
+ * are never probed, and the search only trusts a WDL result right after a capture or pawn move,
+ * when the halfmove clock is 0. At the root the DTZ is compared with the halfmove clock instead.
+ *
+ * tablebaseTest.cpp checks the prober on KQvK, KRvK and KPvK tables it solves and writes itself.
+ *
+ * @author Anshuman Routray
+ */
+
+#ifndef TABLEBASE_HPP
+#define TABLEBASE_HPP
+
+#include "board.hpp"
+#include "mappedFile.hpp"
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+using namespace std;
+
+//Results of a WDL probe, for the player to move
+
+extern const int tablebaseLoss;
+extern const int tablebaseBlessedLoss;
+extern const int tablebaseDraw;
+extern const int tablebaseCursedWin;
+extern const int tablebaseWin;
+
+struct SyzygyTable;
+
+class Tablebases {
+public:
+    Tablebases();
+    ~Tablebases();
+
+    /**
+     * @brief Finds the tables in one or more directories, closing the tables that were open before.
+     *
+     * @param paths: Directories separated by ':' (';' on Windows), like the SyzygyPath of other engines
+     *
+     * @return True if at least one WDL table was found, otherwise false.
+     */
+    bool open(const string& paths);
+
+    void close();
+
+    bool isOpen() const { return largest > 0; }
+
+    /**
+     * @brief The most pieces (kings included) of any table found, 0 if none were found.
+     */
+    int largestTable() const { return largest; }
+
+    /**
+     * @brief Looks the result of a position up in the WDL tables.
+     *
+     * Captures, en passant included, are tried first, because the tables may store anything for
+     * positions where a capture decides the result.
+     *
+     * @param board: The chessboard, without castling rights
+     *
+     * @param wdl: Receives tablebaseLoss to tablebaseWin for the player to move
+     *
+     * @return False if a table needed was missing or the position has castling rights or too many pieces.
+     */
+    bool probeWDL(const vector<vector<int>>& board, int& wdl);
+
+    /**
+     * @brief Looks the distance to zeroing of a position up in the DTZ tables.
+     *
+     * @param dtz: Receives the plies to the next capture or pawn move of the best play, positive if
+     * the player to move wins, negative if they lose and 0 for a draw. Cursed wins and blessed
+     * losses are 100 further away, so they are beyond the fifty move rule.
+     *
+     * @return False if a table needed was missing or the position cannot be probed.
+     */
+    bool probeDTZ(const vector<vector<int>>& board, int& dtz);
+
+    /**
+     * @brief Picks the root move that keeps the best result, counting the fifty move rule from the
+     * halfmove clock of the board: the quickest way to a win, or the slowest loss.
+     *
+     * @param board: The chessboard, which has to have a legal move
+     *
+     * @param wdl: Receives the result of the move, with wins the fifty move rule would stop counted
+     * as cursed wins
+     *
+     * @return The board after the move, or an empty board if the position could not be probed.
+     */
+    vector<vector<int>> bestMove(const vector<vector<int>>& board, int& wdl);
+
+private:
+    SyzygyTable* findTable(const vector<vector<int>>& board, bool& flipped);
+    bool mapTable(SyzygyTable& table, bool dtz);
+    int probeTable(const vector<vector<int>>& board, bool dtz, int wdl, bool& failed, bool& changeSide);
+    int searchWDL(const vector<vector<int>>& board, bool checkZeroing, bool& failed, bool& zeroingBest);
+
+    vector<unique_ptr<SyzygyTable>> tables;
+    map<string, SyzygyTable*> tablesByMaterial;  // every table under its material and the colours swapped
+    mutex mappingLock;
+    int largest = 0;
+};
+
+extern Tablebases tablebases;
+
+/**
+ * @brief Turns a WDL result into an evaluation: wins score below mates but above anything the
+ * evaluation gives, sooner wins higher, and cursed wins and blessed losses are draws.
+ *
+ * @param wdl: The result for the player to move
+ *
+ * @param player: The player to move
+ *
+ * @param ply: The distance of the position from the root of the search
+ */
+double tablebaseScore(int wdl, int player, int ply);
+
+#endif
@@ -0,0 +1,806 @@
+/**
+ * @brief Checks the Syzygy prober on KQvK, KRvK and KPvK tables
+ *
+ * The three endgames are solved by retrograde analysis with FrostWeb's own move generator: the
+ * result of every position and its distance to zeroing, with a checkmate counted as zeroing like
+ * the prober counts it. The solutions are written as .rtbw and .rtbz files the way the Syzygy
+ * generator lays them out: positions under the index of the format, Huffman coded symbols that
+ * stand for runs of equal values, blocks found through a sparse index and DTZ values through a map.
+ * KNvK and KBvK, which underpromotions lead to, are written as draws, and so is a KPvKP table that
+ * only stands in for the real one. The files are then opened like a SyzygyPath and probed:
+ *
+ * - positions with a known result, among them two where an en passant capture into KPvK wins. The
+ *   stand-in says draw for them, like a real table may say anything where en passant is possible,
+ *   so the prober has to find the capture itself. Without the capture the stand-in's draw comes back;
+ * - every legal position of the three endgames, and every one with the colours swapped, against
+ *   the solution, and the move `bestMove` picks in every 61st.
+ *
+ * Usage: `tablebaseTest.exe [directory]`. Given a directory of Syzygy tables, those are checked
+ * instead of the written ones. Their DTZ values may be one ply longer than the solution's, because
+ * tables that store moves rather than plies round them up. Written files go to the working
+ * directory and are removed again. The test takes about a minute and a half.
+ *
+ * It is meant to be compiled like genMove.cpp, with every file that has no main function.
+ *
+ * @author Anshuman Routray
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <queue>
+#include "tablebase.hpp"
+#include "notation.hpp"
+
+using namespace std;
+
+struct KnownPosition {
+    string fen;
+    int wdl;
+    int dtz;
+    bool standIn;   // the result is the KPvKP stand-in's, not the real one
+};
+
+const KnownPosition KNOWN_POSITIONS[] = {
+    {"7k/Q7/6K1/8/8/8/8/8 w - - 0 1", tablebaseWin, 1, false},       // Qa8 and Qg7 mate
+    {"7k/6Q1/6K1/8/8/8/8/8 b - - 0 1", tablebaseLoss, -1, false},    // checkmated
+    {"7k/1Q6/6K1/8/8/8/8/8 b - - 0 1", tablebaseLoss, -2, false},    // Kg8 is the only move, then mate
+    {"7k/5K2/6Q1/8/8/8/8/8 b - - 0 1", tablebaseDraw, 0, false},     // stalemate
+    {"7k/6Q1/8/8/8/8/8/K7 b - - 0 1", tablebaseDraw, 0, false},      // Kxg7
+    {"8/8/8/8/8/6k1/q7/7K b - - 0 1", tablebaseWin, 1, false},       // black queen: Qa1 mate
+    {"7k/8/6K1/8/8/8/8/R7 w - - 0 1", tablebaseWin, 1, false},       // Ra8 mate
+    {"8/8/8/8/8/8/6Rk/K7 b - - 0 1", tablebaseDraw, 0, false},       // Kxg2
+    {"8/4P3/8/8/8/8/k7/4K3 w - - 0 1", tablebaseWin, 1, false},      // e8=Q
+    {"8/4P3/8/8/8/8/k7/4K3 b - - 0 1", tablebaseLoss, -2, false},    // every move lets the pawn queen
+    {"4k3/4P3/4K3/8/8/8/8/8 b - - 0 1", tablebaseDraw, 0, false},    // stalemate
+    {"k7/8/8/8/8/8/P7/7K w - - 0 1", tablebaseDraw, 0, false},       // the king holds the corner
+    {"K7/8/8/8/8/8/4p3/7k b - - 0 1", tablebaseWin, 1, false},       // black pawn: e1=Q
+    {"8/2K5/8/3pP3/8/8/8/7k w - d6 0 1", tablebaseWin, 1, false},    // exd6 e.p. queens
+    {"7K/8/8/8/3Pp3/8/2k5/8 b - d3 0 1", tablebaseWin, 1, false},    // exd3 e.p. queens
+    {"8/2K5/8/3pP3/8/8/8/7k w - - 0 1", tablebaseDraw, 0, true},    // no capture, the stand-in answers
+};
+
+//A placement packs the player to move, the white king, the black king and the other piece, which
+//is white: ((blackToMove * 64 + whiteKing) * 64 + blackKing) * 64 + square, with a1 = 0 and h8 = 63
+
+const int PLACEMENTS = 2 * 64 * 64 * 64;
+const int UNKNOWN = 99;
+const int BEST_MOVE_STRIDE = 61; //Every how many positions bestMove is checked
+
+struct Solution {
+    string name;
+    int piece;
+    vector<char> legal;
+    vector<char> mated;
+    vector<int> wdl;    // for the player to move
+    vector<int> dtz;    // plies to zeroing, positive for wins and negative for losses
+};
+
+vector<Solution> solutions;
+
+static int rankOf(int square){ return square >> 3; }
+static int fileOf(int square){ return square & 7; }
+
+vector<vector<int>> placementBoard(int piece, int placement){
+    vector<vector<int>> board(9, vector<int>(8, space));
+    int square = placement & 63, blackKing = (placement >> 6) & 63, whiteKing = (placement >> 12) & 63;
+    board[7 - rankOf(square)][fileOf(square)] = piece;
+    board[7 - rankOf(blackKing)][fileOf(blackKing)] = -king;
+    board[7 - rankOf(whiteKing)][fileOf(whiteKing)] = king;
+    board[8] = {bothCastlingDisabled, bothCastlingDisabled, (placement >> 18) ? blackPlayer : whitePlayer, -1, -1, 0, 1};
+    return board;
+}
+
+//The same position with the colours swapped and the board turned around
+
+vector<vector<int>> swapColours(const vector<vector<int>>& board){
+    vector<vector<int>> swapped = board;
+    for(int row = 0; row < 8; row++){
+        for(int column = 0; column < 8; column++){
+            swapped[row][column] = -board[7 - row][column];
+        }
+    }
+    swapped[8][2] = -board[8][2];
+    return swapped;
+}
+
+bool legalPlacement(int piece, int placement){
+    int square = placement & 63, blackKing = (placement >> 6) & 63, whiteKing = (placement >> 12) & 63;
+    if(square == blackKing || square == whiteKing || whiteKing == blackKing){
+        return false;
+    }
+    if(abs(rankOf(whiteKing) - rankOf(blackKing)) <= 1 && abs(fileOf(whiteKing) - fileOf(blackKing)) <= 1){
+        return false;
+    }
+    if(piece == pawn && (rankOf(square) == 0 || rankOf(square) == 7)){
+        return false;
+    }
+
+    //The player who just moved cannot be in check
+
+    vector<vector<int>> board = placementBoard(piece, placement);
+    board[8][2] = -board[8][2];
+    return !isInCheck(board);
+}
+
+//A move is the placement it leads to, whether it zeroes and the endgame plus one, 0 for a draw
+//without a table (bare kings, or a knight or bishop after an underpromotion)
+
+uint32_t packMove(const vector<vector<int>>& newBoard){
+    int square = 0, whiteKing = 0, blackKing = 0, piece = space;
+    for(int row = 0; row < 8; row++){
+        for(int column = 0; column < 8; column++){
+            int found = newBoard[row][column], at = (7 - row) * 8 + column;
+            if(found == king){
+                whiteKing = at;
+            }
+            else if(found == -king){
+                blackKing = at;
+            }
+            else if(found != space){
+                piece = found;
+                square = at;
+            }
+        }
+    }
+    int endgame = 0;
+    for(size_t i = 0; i < solutions.size(); i++){
+        if(solutions[i].piece == piece){
+            endgame = (int)i + 1;
+        }
+    }
+    int placement = (((newBoard[8][2] == blackPlayer) * 64 + whiteKing) * 64 + blackKing) * 64 + square;
+    return (uint32_t)placement | ((newBoard[8][6] == 0) << 19) | (endgame << 20);
+}
+
+int moveWdl(uint32_t move){
+    int endgame = (move >> 20) - 1;
+    return (endgame < 0) ? tablebaseDraw : solutions[endgame].wdl[move & 0x7FFFF];
+}
+
+/**
+ * Solves the endgame of `solution.piece`, the endgames its promotions lead to have to be solved.
+ */
+void solve(Solution& solution){
+    int piece = solution.piece;
+    solution.legal.assign(PLACEMENTS, false);
+    solution.mated.assign(PLACEMENTS, false);
+    solution.wdl.assign(PLACEMENTS, UNKNOWN);
+    solution.dtz.assign(PLACEMENTS, 0);
+    vector<uint32_t> first(PLACEMENTS + 1, 0), moves;
+    for(int placement = 0; placement < PLACEMENTS; placement++){
+        first[placement] = (uint32_t)moves.size();
+        if(!legalPlacement(piece, placement)){
+            continue;
+        }
+        solution.legal[placement] = true;
+        vector<vector<int>> board = placementBoard(piece, placement);
+        vector<vector<vector<int>>> moveList = generateMoves(board);
+        if(moveList.empty()){
+            solution.mated[placement] = isInCheck(board);
+            solution.wdl[placement] = solution.mated[placement] ? tablebaseLoss : tablebaseDraw;
+            solution.dtz[placement] = solution.mated[placement] ? -1 : 0;
+        }
+        for(const vector<vector<int>>& newBoard : moveList){
+            moves.push_back(packMove(newBoard));
+        }
+    }
+    first[PLACEMENTS] = (uint32_t)moves.size();
+
+    //A position is won if a move leaves the opponent lost, and lost if every move leaves them won
+
+    for(bool changed = true; changed; ){
+        changed = false;
+        for(int placement = 0; placement < PLACEMENTS; placement++){
+            if(!solution.legal[placement] || solution.wdl[placement] != UNKNOWN){
+                continue;
+            }
+            bool lossFound = false, allWins = true;
+            for(uint32_t i = first[placement]; i < first[placement + 1]; i++){
+                int value = moveWdl(moves[i]);
+                lossFound = lossFound || value == tablebaseLoss;
+                allWins = allWins && value == tablebaseWin;
+            }
+            if(lossFound || allWins){
+                solution.wdl[placement] = lossFound ? tablebaseWin : tablebaseLoss;
+                changed = true;
+            }
+        }
+    }
+    for(int& value : solution.wdl){
+        value = (value == UNKNOWN) ? tablebaseDraw : value;
+    }
+
+    //Distances one ply at a time: a zeroing move or a mate costs one ply, any other move one more
+    //than the position it leads to. Wins take the cheapest move, losses the dearest
+
+    for(int level = 1; level <= 1000; level++){
+        bool pending = false;
+        for(int placement = 0; placement < PLACEMENTS; placement++){
+            int wdl = solution.wdl[placement];
+            if(!solution.legal[placement] || wdl == tablebaseDraw || solution.dtz[placement] != 0){
+                continue;
+            }
+            int best = INT32_MAX, worst = 0;
+            bool allKnown = true;
+            for(uint32_t i = first[placement]; i < first[placement + 1]; i++){
+                uint32_t move = moves[i];
+                int to = move & 0x7FFFF;
+                bool zeroing = (move >> 19) & 1;
+                if(moveWdl(move) != -wdl){
+                    continue;
+                }
+                int cost = (zeroing || solution.mated[to]) ? 1 : (solution.dtz[to] != 0) ? 1 + abs(solution.dtz[to]) : 0;
+                allKnown = allKnown && cost > 0;
+                if(cost > 0){
+                    best = min(best, cost);
+                    worst = max(worst, cost);
+                }
+            }
+            if(wdl == tablebaseWin && best == level){
+                solution.dtz[placement] = level;
+            }
+            else if(wdl == tablebaseLoss && allKnown && worst == level){
+                solution.dtz[placement] = -level;
+            }
+            else {
+                pending = true;
+            }
+        }
+        if(!pending){
+            break;
+        }
+    }
+}
+
+//Index tables of the format: the triangle a1-d1-d4 with its diagonal last, and the squares below
+//the a1-h8 diagonal
+
+int mapA1D1D4[64], mapB1H1H7[64];
+
+void buildIndexMaps(){
+    int below = 0, triangle = 0;
+    for(int square = 0; square < 64; square++){
+        if(rankOf(square) < fileOf(square)){
+            mapB1H1H7[square] = below++;
+            if(fileOf(square) <= 3){
+                mapA1D1D4[square] = triangle++;
+            }
+        }
+    }
+    for(int square : {0, 9, 18, 27}){
+        mapA1D1D4[square] = triangle++;
+    }
+}
+
+/**
+ * Index of three pieces without pawns, squares in the order of the part.
+ */
+uint64_t pieceIndex(int squares[3]){
+    if(fileOf(squares[0]) > 3){
+        for(int i = 0; i < 3; i++){
+            squares[i] ^= 7;
+        }
+    }
+    if(rankOf(squares[0]) > 3){
+        for(int i = 0; i < 3; i++){
+            squares[i] ^= 56;
+        }
+    }
+
+    //The first piece off the diagonal goes below it
+
+    for(int i = 0; i < 3; i++){
+        int offDiagonal = rankOf(squares[i]) - fileOf(squares[i]);
+        if(offDiagonal > 0){
+            for(int j = i; j < 3; j++){
+                squares[j] = fileOf(squares[j]) * 8 + rankOf(squares[j]);
+            }
+        }
+        if(offDiagonal != 0){
+            break;
+        }
+    }
+    auto onDiagonal = [](int square){ return rankOf(square) == fileOf(square); };
+    int adjust1 = squares[1] > squares[0];
+    int adjust2 = (squares[2] > squares[0]) + (squares[2] > squares[1]);
+    if(!onDiagonal(squares[0])){
+        return ((uint64_t)mapA1D1D4[squares[0]] * 63 + (squares[1] - adjust1)) * 62 + squares[2] - adjust2;
+    }
+    if(!onDiagonal(squares[1])){
+        return (6 * 63 + rankOf(squares[0]) * 28 + mapB1H1H7[squares[1]]) * 62 + squares[2] - adjust2;
+    }
+    if(!onDiagonal(squares[2])){
+        return 6 * 63 * 62 + 4 * 28 * 62 + rankOf(squares[0]) * 7 * 28 + (rankOf(squares[1]) - adjust1) * 28
+            + mapB1H1H7[squares[2]];
+    }
+    return 6 * 63 * 62 + 4 * 28 * 62 + 4 * 7 * 28 + rankOf(squares[0]) * 7 * 6 + (rankOf(squares[1]) - adjust1) * 6
+        + (rankOf(squares[2]) - adjust2);
+}
+
+/**
+ * Index of a pawn and two kings, the pawn first: its rank, then each king among the squares left.
+ */
+uint64_t pawnIndex(int squares[3]){
+    if(fileOf(squares[0]) > 3){
+        for(int i = 0; i < 3; i++){
+            squares[i] ^= 7;
+        }
+    }
+    int second = squares[1] - (squares[1] > squares[0]);
+    int third = squares[2] - (squares[2] > squares[0]) - (squares[2] > squares[1]);
+    return (rankOf(squares[0]) - 1) + 6 * (second + 63 * (uint64_t)third);
+}
+
+//The writing side of the format
+
+const unsigned char WDL_MAGIC[4] = {0x71, 0xE8, 0x23, 0x5D};
+const unsigned char DTZ_MAGIC[4] = {0xD7, 0x66, 0x0C, 0xA5};
+const int BLACK_STORED = 1, MAPPED = 2, WIN_PLIES = 4, LOSS_PLIES = 8, SINGLE_VALUE = 128;
+const int BLOCK_SIZE_BITS = 5; //Blocks of 32 bytes, so even these small tables have many
+const int SPAN_BITS = 6; //A sparse index entry every 64 values
+
+struct TablePart {
+    vector<int> pieces;         // piece bytes: 1 to 6 for white, 9 to 14 for black
+    int flags = 0;
+    vector<int> values;         // the symbol value of every index
+    vector<int> map[4];         // DTZ values of wins, losses, cursed wins and blessed losses
+};
+
+struct EncodedPart {
+    vector<unsigned char> sizes, sparseIndex, blockLengths, data;
+};
+
+void put16(vector<unsigned char>& bytes, int value){
+    bytes.push_back((unsigned char)value);
+    bytes.push_back((unsigned char)(value >> 8));
+}
+
+void put32(vector<unsigned char>& bytes, uint32_t value){
+    put16(bytes, value & 0xFFFF);
+    put16(bytes, value >> 16);
+}
+
+//Lengths of a Huffman code for the weights
+
+vector<int> huffmanLengths(const vector<uint64_t>& weights){
+    size_t count = weights.size();
+    vector<int> parent(2 * count - 1, -1);
+    priority_queue<pair<uint64_t, int>, vector<pair<uint64_t, int>>, greater<pair<uint64_t, int>>> queue;
+    for(size_t i = 0; i < count; i++){
+        queue.push({weights[i], (int)i});
+    }
+    for(int next = (int)count; queue.size() > 1; next++){
+        pair<uint64_t, int> a = queue.top();
+        queue.pop();
+        pair<uint64_t, int> b = queue.top();
+        queue.pop();
+        parent[a.second] = parent[b.second] = next;
+        queue.push({a.first + b.first, next});
+    }
+    vector<int> lengths(count, 0);
+    for(size_t i = 0; i < count; i++){
+        for(int node = (int)i; parent[node] >= 0; node = parent[node]){
+            lengths[i]++;
+        }
+    }
+    return lengths;
+}
+
+/**
+ * Codes the values of a part. Every value has three symbols: the value alone, a pair of it and a
+ * pair of pairs, and runs are written with the longest that fit.
+ */
+EncodedPart encodePart(const TablePart& part){
+    EncodedPart encoded;
+    const vector<int>& values = part.values;
+    if(count(values.begin(), values.end(), values[0]) == (ptrdiff_t)values.size()){
+        encoded.sizes = {(unsigned char)(part.flags | SINGLE_VALUE), (unsigned char)values[0]};
+        return encoded;
+    }
+    vector<int> distinct = values;
+    sort(distinct.begin(), distinct.end());
+    distinct.erase(unique(distinct.begin(), distinct.end()), distinct.end());
+
+    //Symbol 3 * k + n stands for 2^n times the kth value
+
+    vector<int> tokens;
+    vector<uint64_t> weights(3 * distinct.size(), 1);
+    for(size_t i = 0; i < values.size(); ){
+        size_t run = 1;
+        while(run < 4 && i + run < values.size() && values[i + run] == values[i]){
+            run++;
+        }
+        int symbol = 3 * (int)(lower_bound(distinct.begin(), distinct.end(), values[i]) - distinct.begin());
+        symbol += (run == 4) ? 2 : (run >= 2) ? 1 : 0;
+        tokens.push_back(symbol);
+        weights[symbol]++;
+        i += (size_t)1 << (symbol % 3);
+    }
+
+    //Canonical code: the longest codes get the lowest symbol numbers and the lowest codes
+
+    vector<int> lengths = huffmanLengths(weights);
+    vector<int> order(weights.size());
+    for(size_t i = 0; i < order.size(); i++){
+        order[i] = (int)i;
+    }
+    stable_sort(order.begin(), order.end(), [&lengths](int a, int b){ return lengths[a] > lengths[b]; });
+    vector<int> number(order.size());
+    for(size_t i = 0; i < order.size(); i++){
+        number[order[i]] = (int)i;
+    }
+    int minLength = *min_element(lengths.begin(), lengths.end()), maxLength = *max_element(lengths.begin(), lengths.end());
+    int lengthCount = maxLength - minLength + 1;
+    vector<int> lowest(lengthCount, 0);
+    vector<uint64_t> base(lengthCount, 0);
+    for(int i = lengthCount - 2; i >= 0; i--){
+        int longer = (int)count(lengths.begin(), lengths.end(), minLength + i + 1);
+        lowest[i] = lowest[i + 1] + longer;
+        base[i] = (base[i + 1] + longer) / 2;
+    }
+    vector<uint64_t> codes(order.size());
+    for(size_t symbol = 0; symbol < order.size(); symbol++){
+        int i = lengths[symbol] - minLength;
+        codes[symbol] = base[i] + (number[symbol] - lowest[i]);
+    }
+
+    //Blocks take whole symbols, the sparse index points at the middle of every span
+
+    size_t blockBits = (size_t)8 << BLOCK_SIZE_BITS;
+    vector<size_t> blockStarts;
+    size_t bits = blockBits, position = 0;
+    for(int token : tokens){
+        if(bits + lengths[token] > blockBits){
+            blockStarts.push_back(position);
+            encoded.data.resize(encoded.data.size() + ((size_t)1 << BLOCK_SIZE_BITS), 0);
+            bits = 0;
+        }
+        size_t blockStart = encoded.data.size() - ((size_t)1 << BLOCK_SIZE_BITS);
+        for(int bit = lengths[token] - 1; bit >= 0; bit--, bits++){
+            if((codes[token] >> bit) & 1){
+                encoded.data[blockStart + bits / 8] |= (unsigned char)(0x80 >> (bits % 8));
+            }
+        }
+        position += (size_t)1 << (token % 3);
+    }
+    blockStarts.push_back(values.size());
+    for(size_t block = 0; block + 1 < blockStarts.size(); block++){
+        put16(encoded.blockLengths, (int)(blockStarts[block + 1] - blockStarts[block] - 1));
+    }
+    size_t span = (size_t)1 << SPAN_BITS;
+    for(size_t k = 0; k < (values.size() + span - 1) / span; k++){
+        size_t middle = k * span + span / 2;
+        size_t block = upper_bound(blockStarts.begin(), blockStarts.end() - 1, middle) - blockStarts.begin() - 1;
+        put32(encoded.sparseIndex, (uint32_t)block);
+        put16(encoded.sparseIndex, (int)(middle - blockStarts[block]));
+    }
+
+    encoded.sizes = {(unsigned char)part.flags, (unsigned char)BLOCK_SIZE_BITS, (unsigned char)SPAN_BITS, 0};
+    put32(encoded.sizes, (uint32_t)(blockStarts.size() - 1));
+    encoded.sizes.push_back((unsigned char)maxLength);
+    encoded.sizes.push_back((unsigned char)minLength);
+    for(int i = 0; i < lengthCount; i++){
+        put16(encoded.sizes, lowest[i]);
+    }
+    put16(encoded.sizes, (int)order.size());
+    for(int symbol : order){
+        int left = (symbol % 3) ? number[symbol - 1] : distinct[symbol / 3];
+        int right = (symbol % 3) ? number[symbol - 1] : 0xFFF;
+        encoded.sizes.push_back((unsigned char)left);
+        encoded.sizes.push_back((unsigned char)((left >> 8) | ((right & 0xF) << 4)));
+        encoded.sizes.push_back((unsigned char)(right >> 4));
+    }
+    if(order.size() & 1){
+        encoded.sizes.push_back(0);
+    }
+    return encoded;
+}
+
+/**
+ * Writes a table file, parts[file][side]: one file without pawns, four with, and two sides to move
+ * in WDL files, one in DTZ files.
+ */
+bool writeTable(const string& path, bool dtz, const vector<vector<TablePart>>& parts){
+    bool pawns = parts.size() > 1;
+    const vector<int>& pieces = parts[0][0].pieces;
+    bool pawnsBothSides = count(pieces.begin(), pieces.end(), pawn) && count(pieces.begin(), pieces.end(), pawn + 8);
+    vector<unsigned char> bytes(dtz ? DTZ_MAGIC : WDL_MAGIC, (dtz ? DTZ_MAGIC : WDL_MAGIC) + 4);
+    bytes.push_back((unsigned char)((parts[0].size() > 1) | (pawns ? 2 : 0)));
+
+    //The leading group comes first in the index, then the other colour's pawns
+
+    for(const vector<TablePart>& file : parts){
+        bytes.push_back(0);
+        if(pawnsBothSides){
+            bytes.push_back(0x11);
+        }
+        for(size_t k = 0; k < pieces.size(); k++){
+            bytes.push_back((unsigned char)(file[0].pieces[k] | ((file.size() > 1 ? file[1].pieces[k] : 0) << 4)));
+        }
+    }
+    if(bytes.size() & 1){
+        bytes.push_back(0);
+    }
+    vector<vector<EncodedPart>> encoded;
+    for(const vector<TablePart>& file : parts){
+        encoded.emplace_back();
+        for(const TablePart& part : file){
+            encoded.back().push_back(encodePart(part));
+            bytes.insert(bytes.end(), encoded.back().back().sizes.begin(), encoded.back().back().sizes.end());
+        }
+    }
+    if(dtz){
+        for(const vector<TablePart>& file : parts){
+            if(!(file[0].flags & MAPPED)){
+                continue;
+            }
+            for(const vector<int>& map : file[0].map){
+                bytes.push_back((unsigned char)map.size());
+                bytes.insert(bytes.end(), map.begin(), map.end());
+            }
+        }
+        if(bytes.size() & 1){
+            bytes.push_back(0);
+        }
+    }
+    for(const vector<EncodedPart>& file : encoded){
+        for(const EncodedPart& part : file){
+            bytes.insert(bytes.end(), part.sparseIndex.begin(), part.sparseIndex.end());
+        }
+    }
+    for(const vector<EncodedPart>& file : encoded){
+        for(const EncodedPart& part : file){
+            bytes.insert(bytes.end(), part.blockLengths.begin(), part.blockLengths.end());
+        }
+    }
+    for(const vector<EncodedPart>& file : encoded){
+        for(const EncodedPart& part : file){
+            bytes.resize((bytes.size() + 63) & ~(size_t)63, 0);
+            bytes.insert(bytes.end(), part.data.begin(), part.data.end());
+        }
+    }
+
+    //The decoder reads a few bytes past the block it is in
+
+    bytes.resize(bytes.size() + 64, 0);
+    ofstream output(path, ios::binary);
+    output.write((const char*)bytes.data(), bytes.size());
+    return (bool)output;
+}
+
+/**
+ * Writes a table that holds a draw for every position. KNvK and KBvK are draws, the KPvKP table only
+ * stands in for the real one: the tables may hold anything for positions with an en passant
+ * capture, so the prober has to find the captures' results itself.
+ */
+bool writeDrawTable(const string& name, const vector<int>& pieces){
+    bool pawns = count(pieces.begin(), pieces.end(), pawn) > 0;
+    bool symmetric = count(pieces.begin(), pieces.end(), pawn + 8) > 0;
+    TablePart part;
+    part.pieces = pieces;
+    part.values.assign(1, tablebaseDraw + 2);
+    vector<vector<TablePart>> wdlParts(pawns ? 4 : 1, vector<TablePart>(symmetric ? 1 : 2, part));
+    part.values.assign(1, 0);
+    vector<vector<TablePart>> dtzParts(pawns ? 4 : 1, vector<TablePart>(1, part));
+    return writeTable(name + ".rtbw", false, wdlParts) && writeTable(name + ".rtbz", true, dtzParts);
+}
+
+/**
+ * Puts the solution of an endgame into the parts of its WDL and DTZ files. Positions that share
+ * an index have to share their values, a difference is counted as a conflict.
+ */
+int fillParts(const Solution& solution, vector<vector<TablePart>>& wdlParts, vector<vector<TablePart>>& dtzParts){
+    bool pawns = solution.piece == pawn;
+    int pieceByte = solution.piece;
+    int files = pawns ? 4 : 1;
+    size_t tableSize = pawns ? 6 * 63 * 62 : 31332;
+    wdlParts.assign(files, vector<TablePart>(2));
+    dtzParts.assign(files, vector<TablePart>(1));
+    for(int file = 0; file < files; file++){
+
+        //The sides store their pieces in different orders, so the prober has to sort them
+
+        int wdlOrders[2][3] = {{pieceByte, king, king + 8}, {king + 8, king, pieceByte}};
+        int pawnOrders[2][3] = {{pawn, king, king + 8}, {pawn, king + 8, king}};
+        for(int side = 0; side < 2; side++){
+            wdlParts[file][side].pieces.assign(pawns ? pawnOrders[side] : wdlOrders[side], (pawns ? pawnOrders[side] : wdlOrders[side]) + 3);
+            wdlParts[file][side].values.assign(tableSize, -1);
+        }
+        TablePart& dtzPart = dtzParts[file][0];
+        dtzPart.pieces.assign(pawns ? pawnOrders[1] : wdlOrders[0], (pawns ? pawnOrders[1] : wdlOrders[0]) + 3);
+        dtzPart.flags = MAPPED | WIN_PLIES | LOSS_PLIES | ((pawns && file >= 2) ? BLACK_STORED : 0);
+        dtzPart.values.assign(tableSize, -1);
+    }
+
+    //DTZ values go through the map of their result
+
+    for(int pass = 0; pass < 2; pass++){
+        for(int placement = 0; placement < PLACEMENTS; placement++){
+            if(!solution.legal[placement]){
+                continue;
+            }
+            int square = placement & 63, blackKing = (placement >> 6) & 63, whiteKing = (placement >> 12) & 63;
+            int side = placement >> 18;
+            int file = pawns ? min(fileOf(square), 7 - fileOf(square)) : 0;
+            int wdl = solution.wdl[placement];
+            auto index = [&](const TablePart& part){
+                int squares[3];
+                for(int k = 0; k < 3; k++){
+                    squares[k] = (part.pieces[k] == king) ? whiteKing : (part.pieces[k] == king + 8) ? blackKing : square;
+                }
+                return pawns ? pawnIndex(squares) : pieceIndex(squares);
+            };
+            TablePart& dtzPart = dtzParts[file][0];
+            if(pass == 0){
+                if(side == (dtzPart.flags & BLACK_STORED) && wdl != tablebaseDraw){
+                    vector<int>& map = dtzPart.map[(wdl == tablebaseWin) ? 0 : 1];
+                    int stored = abs(solution.dtz[placement]) - 1;
+                    if(find(map.begin(), map.end(), stored) == map.end()){
+                        map.push_back(stored);
+                    }
+                }
+                continue;
+            }
+            int& wdlValue = wdlParts[file][side].values[index(wdlParts[file][side])];
+            if(wdlValue >= 0 && wdlValue != wdl + 2){
+                return -1;
+            }
+            wdlValue = wdl + 2;
+            if(side != (dtzPart.flags & BLACK_STORED)){
+                continue;
+            }
+            int dtzValue = 0;
+            if(wdl != tablebaseDraw){
+                const vector<int>& map = dtzPart.map[(wdl == tablebaseWin) ? 0 : 1];
+                dtzValue = (int)(find(map.begin(), map.end(), abs(solution.dtz[placement]) - 1) - map.begin());
+            }
+            int& stored = dtzPart.values[index(dtzPart)];
+            if(stored >= 0 && stored != dtzValue){
+                return -1;
+            }
+            stored = dtzValue;
+        }
+    }
+
+    //Indices of no legal position repeat the value before them, which compresses best
+
+    for(vector<TablePart>& file : wdlParts){
+        for(TablePart& part : file){
+            int last = *max_element(part.values.begin(), part.values.end());
+            for(int& value : part.values){
+                value = last = (value < 0) ? last : value;
+            }
+        }
+    }
+    for(vector<TablePart>& file : dtzParts){
+        int last = max(0, *max_element(file[0].values.begin(), file[0].values.end()));
+        for(int& value : file[0].values){
+            value = last = (value < 0) ? last : value;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Compares the prober with the solution on every legal position and its mirror image, and the move
+ * picked by bestMove on every BEST_MOVE_STRIDE-th.
+ */
+int checkSolution(Tablebases& tables, const Solution& solution, bool realTables){
+    int wrong = 0, checked = 0;
+    for(int placement = 0; placement < PLACEMENTS; placement++){
+        if(!solution.legal[placement]){
+            continue;
+        }
+        vector<vector<int>> board = placementBoard(solution.piece, placement);
+        int wdl = solution.wdl[placement], dtz = solution.dtz[placement];
+        for(int swapped = 0; swapped < 2; swapped++){
+            vector<vector<int>> position = swapped ? swapColours(board) : board;
+            int probedWdl, probedDtz;
+            bool found = tables.probeWDL(position, probedWdl) && tables.probeDTZ(position, probedDtz);
+            bool passed = found && probedWdl == wdl
+                && (probedDtz == dtz || (realTables && abs(probedDtz - dtz) == 1 && probedDtz * dtz > 0));
+            if(passed && !swapped && checked++ % BEST_MOVE_STRIDE == 0 && !generateMoves(position).empty()){
+
+                //The move has to keep the result at the distance of the position
+
+                int moveWdl;
+                vector<vector<int>> newBoard = tables.bestMove(position, moveWdl);
+                int newWdl = 0, newDtz = 0;
+                passed = !newBoard.empty() && moveWdl == wdl && tables.probeWDL(newBoard, newWdl) && newWdl == -wdl
+                    && tables.probeDTZ(newBoard, newDtz);
+                bool mate = passed && isInCheck(newBoard) && generateMoves(newBoard).empty();
+                int cost = (newBoard.empty() || newBoard[8][6] == 0 || mate) ? 1 : 1 + abs(newDtz);
+                passed = passed && (wdl == tablebaseDraw || cost == abs(dtz) || (realTables && abs(cost - abs(dtz)) <= 1));
+            }
+            if(!passed && wrong++ < 5){
+                printf("%-40s wdl %d dtz %d, expected wdl %d dtz %d\n", boardToFen(position).c_str(),
+                    found ? probedWdl : 0, found ? probedDtz : 0, wdl, dtz);
+            }
+        }
+    }
+    return wrong;
+}
+
+int main(int argc, char* argv[]){
+
+    string directory = (argc > 1) ? argv[1] : ".";
+    bool realTables = argc > 1;
+    const int PIECES[] = {queen, rook, pawn};
+    for(int piece : PIECES){
+        solutions.push_back({(piece == queen) ? "KQvK" : (piece == rook) ? "KRvK" : "KPvK", piece, {}, {}, {}, {}});
+    }
+    const pair<string, vector<int>> DRAW_TABLES[] = {
+        {"KNvK", {knight, king, king + 8}},
+        {"KBvK", {bishop, king, king + 8}},
+        {"KPvKP", {pawn, pawn + 8, king, king + 8}},
+    };
+    vector<string> written;
+    if(!realTables){
+        for(const Solution& solution : solutions){
+            written.push_back(solution.name);
+        }
+        for(const pair<string, vector<int>>& table : DRAW_TABLES){
+            written.push_back(table.first);
+        }
+        for(const string& name : written){
+            if(ifstream(name + ".rtbw") || ifstream(name + ".rtbz")){
+                cerr << name << " is in the way, run the test in a directory without tables" << endl;
+                return 1;
+            }
+        }
+    }
+    for(Solution& solution : solutions){
+        solve(solution);
+        int wins = (int)count(solution.wdl.begin(), solution.wdl.end(), tablebaseWin);
+        int longest = *max_element(solution.dtz.begin(), solution.dtz.end());
+        printf("%s solved, %d won positions, the longest win zeroes in %d plies\n", solution.name.c_str(), wins, longest);
+    }
+
+    int failures = 0;
+    if(!realTables){
+        buildIndexMaps();
+        for(const Solution& solution : solutions){
+            vector<vector<TablePart>> wdlParts, dtzParts;
+            bool passed = fillParts(solution, wdlParts, dtzParts) == 0 && writeTable(solution.name + ".rtbw", false, wdlParts)
+                && writeTable(solution.name + ".rtbz", true, dtzParts);
+            printf("%-40s %s\n", ("written " + solution.name).c_str(), passed ? "ok" : "FAILED");
+            failures += !passed;
+        }
+        for(const pair<string, vector<int>>& table : DRAW_TABLES){
+            bool passed = writeDrawTable(table.first, table.second);
+            printf("%-40s %s\n", ("written " + table.first + ", draws only").c_str(), passed ? "ok" : "FAILED");
+            failures += !passed;
+        }
+    }
+
+    Tablebases tables;
+    if(!tables.open(directory) || tables.largestTable() < 4){
+        cerr << "No tables up to KPvKP in " << directory << endl;
+        return 1;
+    }
+    for(const KnownPosition& test : KNOWN_POSITIONS){
+        if(realTables && test.standIn){
+            continue;
+        }
+        vector<vector<int>> board = boardFromFen(test.fen);
+        int wdl = 0, dtz = 0;
+        bool passed = tables.probeWDL(board, wdl) && tables.probeDTZ(board, dtz) && wdl == test.wdl && dtz == test.dtz;
+        printf("%-40s wdl %2d dtz %3d %s\n", test.fen.c_str(), wdl, dtz, passed ? "ok" : "FAILED");
+        failures += !passed;
+    }
+    for(const Solution& solution : solutions){
+        int wrong = checkSolution(tables, solution, realTables);
+        printf("%-40s %d wrong %s\n", (solution.name + " every position").c_str(), wrong, wrong ? "FAILED" : "ok");
+        failures += wrong > 0;
+    }
+    tables.close();
+    for(const string& name : written){
+        remove((name + ".rtbw").c_str());
+        remove((name + ".rtbz").c_str());
+    }
+
+    cout << failures << " failed" << endl;
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,140 @@
+/**
+ * @file transposition.cpp
+ * @brief Implementation of the transposition table and its file backing.
+ * 
+ * @author Anshuman Routray
+ */
+
+#include "transposition.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+using namespace std;
+
+static const char tableMagic[8] = {'F', 'W', 'T', 'A', 'B', 'L', 'E', '\0'};
+static const uint32_t tableVersion = 2;
+
+const int exactBound = 1;
+const int lowerBound = 2;
+const int upperBound = 3;
+
+TranspositionTable savedPositions(1 << 20);
+
+/**
+ * Allocates zeroed entries, halving the size until the memory is available. calloc hands out
+ * pages the operating system zeroes on first use, so an unused table costs nothing at startup.
+ *
+ * @param size: The number of entries, a power of two, receives the number allocated
+ */
+static TableEntry* allocateEntries(size_t& size){
+    while(true){
+        TableEntry* allocated = (TableEntry*)calloc(size, sizeof(TableEntry));
+        if(allocated != nullptr){
+            return allocated;
+        }
+        if(size == 1){
+            throw bad_alloc();
+        }
+        size /= 2;
+    }
+}
+
+TranspositionTable::TranspositionTable(size_t entryCount) : generation(1){
+    size_t size = 1;
+    while(size * 2 <= entryCount){
+        size *= 2;
+    }
+    memory = allocateEntries(size);
+    entries = memory;
+    mask = size - 1;
+}
+
+TranspositionTable::~TranspositionTable(){
+    closeFile();
+    free(memory);
+}
+
+bool TranspositionTable::probe(uint64_t key, int depth, double& evaluation, int& bound) const {
+    const TableEntry& entry = entries[key & mask];
+    uint64_t check = entry.check.load(memory_order_relaxed);
+    uint64_t bits = entry.evaluation.load(memory_order_relaxed);
+    uint64_t info = entry.info.load(memory_order_relaxed);
+    if(info == 0 || (check ^ bits ^ info) != key || (int)(info & 0xFFFF) < depth){
+        return false;
+    }
+    memcpy(&evaluation, &bits, sizeof(bits));
+    bound = (int)((info >> 16) & 3);
+    return true;
+}
+
+void TranspositionTable::store(uint64_t key, int depth, double evaluation, int bound){
+    TableEntry& entry = entries[key & mask];
+    uint64_t oldInfo = entry.info.load(memory_order_relaxed);
+    uint32_t currentGeneration = generation.load(memory_order_relaxed);
+    bool samePosition = (entry.check.load(memory_order_relaxed) ^ entry.evaluation.load(memory_order_relaxed) ^ oldInfo) == key;
+    if(oldInfo != 0 && !samePosition && (uint32_t)(oldInfo >> 32) == currentGeneration && (int)(oldInfo & 0xFFFF) > depth){
+        return;
+    }
+    uint64_t bits;
+    memcpy(&bits, &evaluation, sizeof(bits));
+    uint64_t info = (uint64_t)(depth & 0xFFFF) | ((uint64_t)bound << 16) | ((uint64_t)currentGeneration << 32);
+    entry.evaluation.store(bits, memory_order_relaxed);
+    entry.info.store(info, memory_order_relaxed);
+    entry.check.store(key ^ bits ^ info, memory_order_relaxed);
+}
+
+void TranspositionTable::newSearch(){
+    generation.fetch_add(1, memory_order_relaxed);
+}
+
+bool TranspositionTable::attachFile(const string& path){
+    detachFile();
+    size_t entryCount = mask + 1;
+    size_t fileSize = sizeof(TableHeader) + entryCount * sizeof(TableEntry);
+    if(!file.open(path, fileSize, true)){
+        return false;
+    }
+    TableHeader* header = (TableHeader*)file.data();
+    bool valid = memcmp(header->magic, tableMagic, sizeof(tableMagic)) == 0 && header->version == tableVersion &&
+        header->entrySize == sizeof(TableEntry) && header->entryCount == entryCount && header->dirty == 0;
+    if(!valid){
+        memset(file.data(), 0, fileSize);
+        memcpy(header->magic, tableMagic, sizeof(tableMagic));
+        header->version = tableVersion;
+        header->entrySize = sizeof(TableEntry);
+        header->entryCount = entryCount;
+    }
+
+    //Marked dirty until written back, so a crash mid-search does not leave a half written table behind
+
+    header->dirty = 1;
+    entries = (TableEntry*)(file.data() + sizeof(TableHeader));
+    free(memory);
+    memory = nullptr;
+    return true;
+}
+
+void TranspositionTable::detachFile(){
+    if(!file.isOpen()){
+        return;
+    }
+    size_t size = mask + 1;
+    memory = allocateEntries(size);
+    closeFile();
+    entries = memory;
+    mask = size - 1;
+}
+
+void TranspositionTable::closeFile(){
+    if(!file.isOpen()){
+        return;
+    }
+    file.flush();
+    ((TableHeader*)file.data())->dirty = 0;
+    file.close();
+}
+
+void TranspositionTable::clear(){
+    memset((void*)entries, 0, (mask + 1) * sizeof(TableEntry));
+}
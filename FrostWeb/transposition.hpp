@@ -0,0 +1,121 @@
+/**
+ * @file transposition.hpp
+ * @brief Declaration of the transposition table used by the search.
+ * 
+ * The table is a fixed-size array of entries indexed by the Zobrist key of a position. It can
+ * live in ordinary memory or be backed by a memory-mapped file, in which case everything the
+ * search learned is still there the next time the engine starts.
+ * 
+ * One table is shared by every searching thread. It is lockless: each entry stores its key XORed
+ * with its other two words, so an entry torn by two threads writing at once reads as a miss.
+ * 
+ * @author Anshuman Routray
+ */
+
+#ifndef TRANSPOSITION_HPP
+#define TRANSPOSITION_HPP
+
+#include "mappedFile.hpp"
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+using namespace std;
+
+//What a stored evaluation means, a search cut off at alpha or beta only knows a bound
+
+extern const int exactBound;
+extern const int lowerBound;
+extern const int upperBound;
+
+struct TableEntry {
+    atomic<uint64_t> check;       // key XOR evaluation XOR info
+    atomic<uint64_t> evaluation;  // bits of the evaluation
+    atomic<uint64_t> info;        // depth (bits 0-15), bound (bits 16-17), generation (bits 32-63), 0 if empty
+};
+
+// Start of a table file, files with a different layout or that were not closed properly are ignored
+
+struct TableHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t entrySize;
+    uint64_t entryCount;
+    uint32_t dirty;
+    uint32_t reserved;
+};
+
+class TranspositionTable {
+public:
+
+    /**
+     * @brief Creates an in-memory table.
+     * 
+     * @param entryCount: The number of entries, rounded down to a power of two, and halved
+     * further while that much memory is not available
+     */
+    explicit TranspositionTable(size_t entryCount);
+    ~TranspositionTable();
+
+    /**
+     * @brief Looks up the evaluation of a position.
+     * 
+     * @param key: The Zobrist key of the position
+     * 
+     * @param depth: The depth the caller is going to search the position at
+     * 
+     * @param evaluation: Receives the stored evaluation on a hit
+     * 
+     * @param bound: Receives exactBound, lowerBound or upperBound on a hit
+     * 
+     * @return True if the position was stored from a search at least as deep, otherwise false.
+     */
+    bool probe(uint64_t key, int depth, double& evaluation, int& bound) const;
+
+    /**
+     * @brief Stores the evaluation of a position.
+     * 
+     * An entry from an earlier search (an older generation) is always replaced, an entry from
+     * the current search only by the same position or a search at least as deep.
+     */
+    void store(uint64_t key, int depth, double evaluation, int bound);
+
+    /**
+     * @brief Starts a new generation, called once at the start of every search.
+     */
+    void newSearch();
+
+    /**
+     * @brief Moves the table into a memory-mapped file.
+     * 
+     * An existing file is used as it is if its header matches this build and table size,
+     * otherwise it is cleared. The file is locked while it is attached, so a file another
+     * process is using is never cleared or resized: attaching it fails and this process keeps
+     * its own table in memory. The file is written back when the table is destroyed.
+     * 
+     * @param path: The path of the table file
+     * 
+     * @return True if the file was mapped, otherwise false (the table stays in memory).
+     */
+    bool attachFile(const string& path);
+
+    /**
+     * @brief Writes a file backed table back to disk and returns to an empty in-memory table.
+     */
+    void detachFile();
+
+    void clear();
+
+private:
+    void closeFile();
+
+    size_t mask;
+    TableEntry* entries;
+    TableEntry* memory;
+    MappedFile file;
+    atomic<uint32_t> generation;
+};
+
+extern TranspositionTable savedPositions;
+
+#endif
@@ -0,0 +1,388 @@
+/**
+ * @brief Tunes the piece values and piece-square tables on positions labelled with game results
+ *
+ * Texel's method: the evaluation of a position, squashed by a sigmoid, should predict the result
+ * of the game it was played in. The tool minimises the mean squared error between the two by
+ * gradient descent (Adam) over `pieceValues` and `piecePos` and writes the tuned tables as C++ to
+ * paste over the ones in evaluate.cpp.
+ *
+ * Every position is first resolved to a quiet one by a capture-only search, once, on every
+ * worker. The evaluation of the quiet position is linear in the tables, everything else it scores
+ * (pawn structure, king safety) does not change while tuning and is kept as a constant, so an epoch
+ * only adds up table entries and runs through millions of positions in seconds.
+ *
+ * Positions are read one per line as FEN or EPD with the result of the game from white's point of
+ * view, as `[1.0]`/`[0.5]`/`[0.0]` or `1-0`/`1/2-1/2`/`0-1` (for example in a `c9` operation).
+ * A file ending in `.bin` is read as the training records selfPlay.cpp writes instead.
+ *
+ * Usage: `tune.exe <positions> <output> <epochs>` followed by engine options like `--Threads 8`.
+ *
+ * It is meant to be compiled like genMove.cpp, with every file that has no main function.
+ *
+ * @author Anshuman Routray
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <thread>
+#include "attacks.hpp"
+#include "evaluate.hpp"
+#include "notation.hpp"
+#include "options.hpp"
+
+using namespace std;
+
+const double LEARNING_RATE = 0.01; //Largest step of a table entry per epoch, in pawns
+const int QUIESCENCE_DEPTH = 8; //Captures followed before a position counts as quiet
+
+//Table entries being tuned: the values of pawn to queen, then the 64 squares of pawn to king
+//(the kings are always both on the board, so their value cancels out)
+
+const int VALUE_COUNT = 5;
+const int PARAMETER_COUNT = VALUE_COUNT + 6 * 64;
+
+struct TrainingPosition {
+    PackedBoard quiet;      // the position after the captures are resolved
+    float constant;         // the part of the evaluation the tables do not change
+    float result;           // 1 white won, 0.5 draw, 0 black won
+};
+
+/**
+ * Calls visit(parameter, sign) for every table entry the evaluation of a packed position adds
+ * (sign 1) or subtracts (sign -1).
+ */
+template<typename Visitor>
+void visitParameters(const PackedBoard& packed, Visitor visit){
+    uint64_t occupancy = packed.occupancy;
+    for(int count = 0; occupancy; count++){
+        int square = popSquare(occupancy);
+        int code = (count % 2) ? (packed.pieces[count / 2] >> 4) : (packed.pieces[count / 2] & 15);
+        int piece = (code < 8) ? code : code - 8;
+        int sign = (code < 8) ? 1 : -1;
+        if(piece < king){
+            visit(piece - 1, sign);
+        }
+        visit(VALUE_COUNT + (piece - 1) * 64 + square, sign);
+    }
+}
+
+double linearEvaluation(const PackedBoard& packed, const vector<double>& parameters){
+    double evaluation = 0;
+    visitParameters(packed, [&](int parameter, int sign){
+        evaluation += sign * parameters[parameter];
+    });
+    return evaluation;
+}
+
+/**
+ * Material of both players, which only captures and promotions change.
+ */
+int material(const vector<vector<int>>& board){
+    int total = 0;
+    for(int row = 0; row < 8; row++){
+        for(int column = 0; column < 8; column++){
+            total += pieceValues[abs(board[row][column])];
+        }
+    }
+    return total;
+}
+
+/**
+ * Searches captures only, from white's point of view like search(), and keeps the position at the
+ * end of the best line in `leaf`.
+ */
+double quiesce(const vector<vector<int>>& board, double bestOfWhite, double bestOfBlack, int depth, vector<vector<int>>& leaf){
+    double standPat = cachedEvaluate(board);
+    leaf = board;
+    int player = board[8][2];
+    if(player == whitePlayer ? standPat >= bestOfBlack : standPat <= bestOfWhite){
+        return standPat;
+    }
+    if(player == whitePlayer){
+        bestOfWhite = max(bestOfWhite, standPat);
+    }
+    else {
+        bestOfBlack = min(bestOfBlack, standPat);
+    }
+    if(depth == 0){
+        return standPat;
+    }
+    double best = standPat;
+    int before = material(board);
+    vector<vector<int>> childLeaf;
+
+    //The most valuable captures first, so the bounds close early
+
+    vector<pair<int, vector<vector<int>>>> captures;
+    for(vector<vector<int>>& newBoard : generateMoves(board)){
+        int change = abs(material(newBoard) - before);
+        if(change){
+            captures.push_back({change, move(newBoard)});
+        }
+    }
+    stable_sort(captures.begin(), captures.end(), [](const auto& first, const auto& second){
+        return first.first > second.first;
+    });
+    for(const auto& [change, newBoard] : captures){
+        double evaluation = quiesce(newBoard, bestOfWhite, bestOfBlack, depth - 1, childLeaf);
+        if(player == whitePlayer ? evaluation > best : evaluation < best){
+            best = evaluation;
+            leaf = childLeaf;
+            if(player == whitePlayer){
+                bestOfWhite = max(bestOfWhite, best);
+            }
+            else {
+                bestOfBlack = min(bestOfBlack, best);
+            }
+            if(bestOfWhite >= bestOfBlack){
+                break;
+            }
+        }
+    }
+    return best;
+}
+
+/**
+ * Reads the result of a labelled line, false if it has none.
+ */
+bool parseResult(const string& line, float& result){
+    size_t bracket = line.find('[');
+    if(bracket != string::npos){
+        result = (float)atof(line.c_str() + bracket + 1);
+        return result >= 0 && result <= 1;
+    }
+    if(line.find("1/2-1/2") != string::npos){
+        result = 0.5f;
+    }
+    else if(line.find("1-0") != string::npos){
+        result = 1.0f;
+    }
+    else if(line.find("0-1") != string::npos){
+        result = 0.0f;
+    }
+    else {
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Runs work(first, last) on every worker thread, each with its share of `count` items.
+ */
+template<typename Work>
+void parallelFor(size_t count, Work work){
+    vector<thread> workers;
+    size_t share = (count + threadCount - 1) / threadCount;
+    for(int i = 0; i < threadCount; i++){
+        size_t first = min(count, i * share), last = min(count, first + share);
+        workers.emplace_back([&work, first, last, i](){ work(first, last, i); });
+    }
+    for(thread& worker : workers){
+        worker.join();
+    }
+}
+
+double sigmoid(double evaluation, double scale){
+    return 1.0 / (1.0 + exp(-scale * evaluation));
+}
+
+double meanError(const vector<TrainingPosition>& positions, const vector<double>& parameters, double scale){
+    vector<double> errors(threadCount, 0.0);
+    parallelFor(positions.size(), [&](size_t first, size_t last, int worker){
+        for(size_t i = first; i < last; i++){
+            double error = positions[i].result - sigmoid(linearEvaluation(positions[i].quiet, parameters) + positions[i].constant, scale);
+            errors[worker] += error * error;
+        }
+    });
+    double total = 0;
+    for(double error : errors){
+        total += error;
+    }
+    return total / max(positions.size(), (size_t)1);
+}
+
+/**
+ * Writes a table entry like the hand written ones: rounded to a centipawn, at least one decimal.
+ */
+string formatValue(double value){
+    char text[32];
+    snprintf(text, sizeof(text), "%.2f", round(value * 100) / 100 + 0.0);
+    string formatted = text;
+    if(formatted.back() == '0'){
+        formatted.pop_back();
+    }
+    return (formatted == "-0.0") ? "0.0" : formatted;
+}
+
+int main(int argc, char* argv[]){
+
+    if(argc < 4){
+        cerr << "Usage: " << argv[0] << " <positions> <output> <epochs> [--Name value ...]" << endl;
+        return 1;
+    }
+    int epochs = max(0, atoi(argv[3]));
+    parseOptions(argc - 3, argv + 3);
+
+    ifstream file(argv[1], ios::binary);
+    if(!file){
+        cerr << "Could not open " << argv[1] << endl;
+        return 1;
+    }
+    vector<vector<vector<int>>> boards;
+    vector<float> results;
+    string path = argv[1];
+    if(path.size() > 4 && path.compare(path.size() - 4, 4, ".bin") == 0){
+        TrainingRecord record;
+        while(file.read((char*)&record, sizeof(record))){
+            boards.push_back(unpackBoard(record.board));
+            results.push_back((record.result + 1) / 2.0f);
+        }
+    }
+    else {
+        string line;
+        while(getline(file, line)){
+            float result;
+            vector<vector<int>> board = boardFromFen(line);
+            if(!board.empty() && parseResult(line, result)){
+                boards.push_back(board);
+                results.push_back(result);
+            }
+        }
+    }
+
+    //The tables the engine was built with are the starting point
+
+    vector<double> parameters(PARAMETER_COUNT);
+    for(int piece = pawn; piece <= king; piece++){
+        if(piece < king){
+            parameters[piece - 1] = pieceValues[piece];
+        }
+        for(int square = 0; square < 64; square++){
+            parameters[VALUE_COUNT + (piece - 1) * 64 + square] = piecePos[piece][square / 8][square % 8];
+        }
+    }
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    vector<TrainingPosition> positions(boards.size());
+    vector<char> usable(boards.size(), 0);
+    parallelFor(boards.size(), [&](size_t first, size_t last, int){
+        vector<vector<int>> leaf;
+        for(size_t i = first; i < last; i++){
+            quiesce(boards[i], -1000, 1000, QUIESCENCE_DEPTH, leaf);
+            TrainingPosition& position = positions[i];
+            if(packBoard(leaf, position.quiet)){
+                position.constant = (float)(evaluate(leaf) - linearEvaluation(position.quiet, parameters));
+                position.result = results[i];
+                usable[i] = 1;
+            }
+        }
+    });
+    size_t kept = 0;
+    for(size_t i = 0; i < positions.size(); i++){
+        if(usable[i]){
+            positions[kept++] = positions[i];
+        }
+    }
+    positions.resize(kept);
+    boards.clear();
+    boards.shrink_to_fit();
+    cout << "positions " << positions.size() << ", resolved in "
+        << chrono::duration<double>(chrono::steady_clock::now() - start).count() << "s" << endl;
+    if(positions.empty()){
+        return 1;
+    }
+
+    //The sigmoid scale that fits the current tables best, found by ternary search
+
+    double low = 0.05, high = 5.0;
+    for(int i = 0; i < 40; i++){
+        double left = low + (high - low) / 3, right = high - (high - low) / 3;
+        if(meanError(positions, parameters, left) < meanError(positions, parameters, right)){
+            high = right;
+        }
+        else {
+            low = left;
+        }
+    }
+    double scale = (low + high) / 2;
+    cout << "scale " << scale << ", error " << meanError(positions, parameters, scale) << endl;
+
+    //Adam: every entry moves by about the learning rate in the direction its recent gradients agree on
+
+    vector<double> momentum(PARAMETER_COUNT, 0.0), velocity(PARAMETER_COUNT, 0.0);
+    const double beta1 = 0.9, beta2 = 0.999;
+    for(int epoch = 1; epoch <= epochs; epoch++){
+        chrono::steady_clock::time_point epochStart = chrono::steady_clock::now();
+        vector<vector<double>> gradients(threadCount, vector<double>(PARAMETER_COUNT, 0.0));
+        vector<double> errors(threadCount, 0.0);
+        parallelFor(positions.size(), [&](size_t first, size_t last, int worker){
+            vector<double>& gradient = gradients[worker];
+            for(size_t i = first; i < last; i++){
+                const TrainingPosition& position = positions[i];
+                double predicted = sigmoid(linearEvaluation(position.quiet, parameters) + position.constant, scale);
+                double error = position.result - predicted;
+                errors[worker] += error * error;
+                double slope = -2 * error * predicted * (1 - predicted) * scale;
+                visitParameters(position.quiet, [&](int parameter, int sign){
+                    gradient[parameter] += sign * slope;
+                });
+            }
+        });
+        double error = 0;
+        for(int worker = 0; worker < threadCount; worker++){
+            error += errors[worker];
+        }
+        for(int parameter = 0; parameter < PARAMETER_COUNT; parameter++){
+            double gradient = 0;
+            for(int worker = 0; worker < threadCount; worker++){
+                gradient += gradients[worker][parameter];
+            }
+            gradient /= positions.size();
+            momentum[parameter] = beta1 * momentum[parameter] + (1 - beta1) * gradient;
+            velocity[parameter] = beta2 * velocity[parameter] + (1 - beta2) * gradient * gradient;
+            double corrected = momentum[parameter] / (1 - pow(beta1, epoch));
+            parameters[parameter] -= LEARNING_RATE * corrected / (sqrt(velocity[parameter] / (1 - pow(beta2, epoch))) + 1e-12);
+        }
+        cout << "epoch " << epoch << " error " << error / positions.size() << " ("
+            << chrono::duration<double>(chrono::steady_clock::now() - epochStart).count() << "s)" << endl;
+    }
+
+    //pieceValues holds whole pawns, what is left over moves into every square of the piece's table
+
+    vector<int> values = {0, 0, 0, 0, 0, 0, pieceValues[king]};
+    for(int piece = pawn; piece < king; piece++){
+        values[piece] = (int)lround(parameters[piece - 1]);
+        for(int square = 0; square < 64; square++){
+            parameters[VALUE_COUNT + (piece - 1) * 64 + square] += parameters[piece - 1] - values[piece];
+        }
+    }
+
+    ofstream output(argv[2]);
+    const char* names[7] = {"", "Pawn", "Knight", "Bishop", "Rook", "Queen", "King"};
+    output << "//Tuned by tune.cpp on " << positions.size() << " positions, error " << meanError(positions, parameters, scale)
+        << " before rounding" << endl << endl;
+    output << "const vector<int> pieceValues = {";
+    for(int piece = 0; piece <= king; piece++){
+        output << values[piece] << (piece < king ? ", " : "};\n\n");
+    }
+    output << "double piecePos[7][8][8] = {" << endl << "    // No piece" << endl << "    {" << endl;
+    for(int row = 0; row < 8; row++){
+        output << "        {0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0}" << (row < 7 ? "," : "") << endl;
+    }
+    for(int piece = pawn; piece <= king; piece++){
+        output << "    }," << endl << "    // " << names[piece] << " positions" << endl << "    {" << endl;
+        for(int row = 0; row < 8; row++){
+            output << "        {";
+            for(int column = 0; column < 8; column++){
+                output << formatValue(parameters[VALUE_COUNT + (piece - 1) * 64 + row * 8 + column]) << (column < 7 ? ", " : "}");
+            }
+            output << (row < 7 ? "," : "") << endl;
+        }
+    }
+    output << "    }" << endl << "};" << endl;
+    cout << "tables written to " << argv[2] << endl;
+    return 0;
+}
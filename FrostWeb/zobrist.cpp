@@ -0,0 +1,86 @@
+/**
+ * @file zobrist.cpp
+ * @brief Implementation of the Zobrist hashing used to identify chess positions.
+ * 
+ * The random keys are generated at compile time with the SplitMix64 generator, so they are
+ * the same in every build and cost nothing at startup.
+ * 
+ * @author Anshuman Routray
+ */
+
+#include "zobrist.hpp"
+#include <array>
+
+using namespace std;
+
+struct ZobristKeys {
+    array<array<uint64_t, 64>, 13> pieces{}; // indexed by piece + king, so black pieces come first
+    array<array<uint64_t, 4>, 2> castling{}; // indexed by player slot and castling state
+    array<uint64_t, 8> enPassant{};          // indexed by the column of the double space pawn move
+    uint64_t blackToMove = 0;
+};
+
+static constexpr uint64_t splitMix64(uint64_t& state){
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static constexpr ZobristKeys generateKeys(){
+    ZobristKeys keys;
+    uint64_t state = 0x46726F7374576562ULL;
+    for(auto& piece : keys.pieces){
+        for(uint64_t& key : piece){
+            key = splitMix64(state);
+        }
+    }
+
+    //Empty squares never change the key
+
+    for(uint64_t& key : keys.pieces[6]){
+        key = 0;
+    }
+    for(auto& player : keys.castling){
+        for(uint64_t& key : player){
+            key = splitMix64(state);
+        }
+    }
+    for(uint64_t& key : keys.enPassant){
+        key = splitMix64(state);
+    }
+    keys.blackToMove = splitMix64(state);
+    return keys;
+}
+
+static constexpr ZobristKeys zobristKeys = generateKeys();
+
+uint64_t zobristKey(const vector<vector<int>>& board){
+    uint64_t key = 0;
+    for(int row = 0; row < 8; row++){
+        for(int column = 0; column < 8; column++){
+            key ^= zobristKeys.pieces[board[row][column] + king][row * 8 + column];
+        }
+    }
+    key ^= zobristKeys.castling[0][board[8][0]];
+    key ^= zobristKeys.castling[1][board[8][1]];
+    if(board[8][2] == blackPlayer){
+        key ^= zobristKeys.blackToMove;
+    }
+    if(board[8][5] == 1){
+        key ^= zobristKeys.enPassant[board[8][4]];
+    }
+    return key;
+}
+
+uint64_t pawnKey(const vector<vector<int>>& board){
+    uint64_t key = 0;
+    for(int row = 1; row < 7; row++){
+        for(int column = 0; column < 8; column++){
+            if(abs(board[row][column]) == pawn){
+                key ^= zobristKeys.pieces[board[row][column] + king][row * 8 + column];
+            }
+        }
+    }
+    return key;
+}
@@ -0,0 +1,36 @@
+/**
+ * @file zobrist.hpp
+ * @brief Declaration of the Zobrist hashing used to identify chess positions.
+ * 
+ * Every piece on every square, the player to move, the castling states and the en passant
+ * file get their own random 64 bit key. The key of a board is the XOR of the keys of
+ * everything on it, so two boards with the same key are (almost certainly) the same position.
+ * 
+ * @author Anshuman Routray
+ */
+
+#ifndef ZOBRIST_HPP
+#define ZOBRIST_HPP
+
+#include "board.hpp"
+#include <cstdint>
+
+/**
+ * @brief Computes the Zobrist key of a board.
+ * 
+ * @param board: The chessboard, including its metadata row
+ * 
+ * @return The 64 bit key of the position.
+ */
+uint64_t zobristKey(const vector<vector<int>>& board);
+
+/**
+ * @brief Computes the Zobrist key of only the pawns on a board.
+ * 
+ * @param board: The chessboard
+ * 
+ * @return The 64 bit key of the pawn structure.
+ */
+uint64_t pawnKey(const vector<vector<int>>& board);
+
+#endif